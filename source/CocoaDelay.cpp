@@ -14,7 +14,7 @@ void CocoaDelay::InitParameters()
 	GetParam(Parameters::feedback)->InitDouble("Feedback amount", 0.5, -1.0, 1.0, .01);
 	GetParam(Parameters::stereoOffset)->InitDouble("Stereo offset", 0.0, -.5, .5, .01);
 	GetParam(Parameters::panMode)->InitEnum("Pan mode", (int)PanModes::stationary, (int)PanModes::numPanModes);
-	GetParam(Parameters::pan)->InitDouble("Panning", 0.0, -pi * .5, pi * .5, .01);
+	GetParam(Parameters::pan)->InitDouble("Panning", 0.0, -Util::pi * .5, Util::pi * .5, .01);
 	GetParam(Parameters::duckAmount)->InitDouble("Ducking amount", 0.0, 0.0, 10.0, .01, "", "", 1.0);
 	GetParam(Parameters::duckAttackSpeed)->InitDouble("Ducking attack", 10.0, .1, 100.0, .01, "", "", 2.0);
 	GetParam(Parameters::duckReleaseSpeed)->InitDouble("Ducking release", 10.0, .1, 100.0, .01, "", "", 2.0);
@@ -27,6 +27,12 @@ void CocoaDelay::InitParameters()
 	GetParam(Parameters::driveIterations)->InitInt("Drive iterations", 1, 1, 16);
 	GetParam(Parameters::dryVolume)->InitDouble("Dry volume", 1.0, 0.0, 2.0, .01);
 	GetParam(Parameters::wetVolume)->InitDouble("Wet volume", .5, 0.0, 2.0, .01);
+	GetParam(Parameters::driveMode)->InitEnum("Drive mode", (int)DriveModes::standard, (int)DriveModes::numDriveModes);
+	GetParam(Parameters::oversampling)->InitEnum("Drive oversampling", 0, 4);
+	GetParam(Parameters::reproducibleDrift)->InitBool("Reproducible drift", false);
+	// a different seed for each new instance, so instances only share their
+	// drift if the user sets them to the same seed. it's saved like any other parameter
+	GetParam(Parameters::driftSeed)->InitInt("Drift seed", (int)(Random::GetRandomSeed() % 10000), 0, 9999);
 
 	// tempo sync time display text
 	GetParam(Parameters::tempoSyncTime)->SetDisplayText((int)TempoSyncTimes::tempoSyncOff, "Off");
@@ -60,6 +66,16 @@ void CocoaDelay::InitParameters()
 	GetParam(Parameters::filterMode)->SetDisplayText((int)FilterModes::twoPole, "2 pole");
 	GetParam(Parameters::filterMode)->SetDisplayText((int)FilterModes::fourPole, "4 pole");
 	GetParam(Parameters::filterMode)->SetDisplayText((int)FilterModes::stateVariable, "State variable");
+
+	// drive mode display text
+	GetParam(Parameters::driveMode)->SetDisplayText((int)DriveModes::standard, "Standard");
+	GetParam(Parameters::driveMode)->SetDisplayText((int)DriveModes::antialiased, "Antialiased");
+
+	// oversampling display text
+	GetParam(Parameters::oversampling)->SetDisplayText(0, "1x");
+	GetParam(Parameters::oversampling)->SetDisplayText(1, "2x");
+	GetParam(Parameters::oversampling)->SetDisplayText(2, "4x");
+	GetParam(Parameters::oversampling)->SetDisplayText(3, "8x");
 }
 
 void CocoaDelay::InitGraphics()
@@ -113,276 +129,114 @@ CocoaDelay::CocoaDelay(IPlugInstanceInfo instanceInfo)
 	InitParameters();
 	InitGraphics();
 	InitPresets();
+	for (int i = 0; i < (int)Parameters::numParameters; i++)
+		parameterValues[i].store(IPlug::GetParam(i)->Value(), std::memory_order_relaxed);
+	UpdateEngineParameters();
+	UpdateGrayOut();
+	tapeThread = std::thread(&CocoaDelay::UpdateTape, this);
 }
 
-CocoaDelay::~CocoaDelay() {}
-
-double CocoaDelay::GetDelayTime()
+CocoaDelay::~CocoaDelay()
 {
-	double delayTime = 0.0;
-	auto beatLength = 60 / GetTempo();
-	switch ((TempoSyncTimes)(int)GetParam(Parameters::tempoSyncTime)->Value())
-	{
-	case TempoSyncTimes::tempoSyncOff:
-		delayTime = GetParam(Parameters::delayTime)->Value();
-		break;
-	case TempoSyncTimes::whole:               delayTime = beatLength * 4;    break;
-	case TempoSyncTimes::dottedHalf:          delayTime = beatLength * 3;    break;
-	case TempoSyncTimes::half:                delayTime = beatLength * 2;    break;
-	case TempoSyncTimes::tripletHalf:         delayTime = beatLength * 4/3;  break;
-	case TempoSyncTimes::dottedQuarter:       delayTime = beatLength * 3/2;  break;
-	case TempoSyncTimes::quarter:             delayTime = beatLength * 1;    break;
-	case TempoSyncTimes::tripletQuarter:      delayTime = beatLength * 2/3;  break;
-	case TempoSyncTimes::dottedEighth:        delayTime = beatLength * 3/4;  break;
-	case TempoSyncTimes::eighth:              delayTime = beatLength * 1/2;  break;
-	case TempoSyncTimes::tripletEighth:       delayTime = beatLength * 1/3;  break;
-	case TempoSyncTimes::dottedSixteenth:     delayTime = beatLength * 3/8;  break;
-	case TempoSyncTimes::sixteenth:           delayTime = beatLength * 1/4;  break;
-	case TempoSyncTimes::tripletSixteenth:    delayTime = beatLength * 1/6;  break;
-	case TempoSyncTimes::dottedThirtysecond:  delayTime = beatLength * 3/16; break;
-	case TempoSyncTimes::thirtysecond:        delayTime = beatLength * 1/8;  break;
-	case TempoSyncTimes::tripletThirtysecond: delayTime = beatLength * 1/12; break;
-	case TempoSyncTimes::dottedSixtyforth:    delayTime = beatLength * 3/32; break;
-	case TempoSyncTimes::sixtyforth:          delayTime = beatLength * 1/16; break;
-	case TempoSyncTimes::tripletSixtyforth:   delayTime = beatLength * 1/24; break;
-	}
-
-	// modulation
-	auto lfoAmount = GetParam(Parameters::lfoAmount)->Value();
-	if (lfoAmount != 0.0) delayTime = pow(delayTime, 1.0 + lfoAmount * sin(lfoPhase * 2 * pi));
-	auto driftAmount = GetParam(Parameters::driftAmount)->Value();
-	if (driftAmount != 0.0) delayTime = pow(delayTime, 1.0 + driftAmount * sin(driftPhase));
-
-	return delayTime;
+	updatingTape.store(false, std::memory_order_relaxed);
+	tapeThread.join();
 }
 
-void CocoaDelay::GetReadPositions(double &l, double &r)
+void CocoaDelay::UpdateTape()
 {
-	auto offset = GetParam(Parameters::stereoOffset)->Value() * .5;
-	auto baseTime = GetDelayTime();
-	auto timeL = pow(baseTime, 1.0 + offset);
-	auto timeR = pow(baseTime, 1.0 - offset);
-	l = timeL * GetSampleRate();
-	r = timeR * GetSampleRate();
-}
-
-void CocoaDelay::InitBuffer()
-{
-	bufferL.clear();
-	bufferR.clear();
-	for (int i = 0; i < GetSampleRate() * tapeLength; i++)
+	while (updatingTape.load(std::memory_order_relaxed))
 	{
-		bufferL.push_back(0.0);
-		bufferR.push_back(0.0);
+		engine.UpdateTape();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	}
-	writePosition = 0.0;
-	GetReadPositions(readPositionL, readPositionR);
 }
 
-void CocoaDelay::UpdateReadPositions()
-{
-	double targetReadPositionL, targetReadPositionR;
-	GetReadPositions(targetReadPositionL, targetReadPositionR);
-	readPositionL += (targetReadPositionL - readPositionL) * 10.0 * dt;
-	readPositionR += (targetReadPositionR - readPositionR) * 10.0 * dt;
+void CocoaDelay::UpdateEngineParameters()
+{
+	EngineParameters p;
+	p.delayTime = GetParameterValue(Parameters::delayTime);
+	p.lfoAmount = GetParameterValue(Parameters::lfoAmount);
+	p.lfoFrequency = GetParameterValue(Parameters::lfoFrequency);
+	p.driftAmount = GetParameterValue(Parameters::driftAmount);
+	p.driftSpeed = GetParameterValue(Parameters::driftSpeed);
+	p.tempoSyncTime = (TempoSyncTimes)(int)GetParameterValue(Parameters::tempoSyncTime);
+	p.feedback = GetParameterValue(Parameters::feedback);
+	p.stereoOffset = GetParameterValue(Parameters::stereoOffset);
+	p.panMode = (PanModes)(int)GetParameterValue(Parameters::panMode);
+	p.pan = GetParameterValue(Parameters::pan);
+	p.duckAmount = GetParameterValue(Parameters::duckAmount);
+	p.duckAttackSpeed = GetParameterValue(Parameters::duckAttackSpeed);
+	p.duckReleaseSpeed = GetParameterValue(Parameters::duckReleaseSpeed);
+	p.filterMode = (FilterModes)(int)GetParameterValue(Parameters::filterMode);
+	p.lowPassCutoff = GetParameterValue(Parameters::lowPassCutoff);
+	p.highPassCutoff = GetParameterValue(Parameters::highPassCutoff);
+	p.driveGain = GetParameterValue(Parameters::driveGain);
+	p.driveMix = GetParameterValue(Parameters::driveMix);
+	p.driveCutoff = GetParameterValue(Parameters::driveCutoff);
+	p.driveIterations = (int)GetParameterValue(Parameters::driveIterations);
+	p.driveMode = (DriveModes)(int)GetParameterValue(Parameters::driveMode);
+	p.oversampling = 1 << (int)GetParameterValue(Parameters::oversampling);
+	p.dryVolume = GetParameterValue(Parameters::dryVolume);
+	p.wetVolume = GetParameterValue(Parameters::wetVolume);
+	engine.SetParameters(p);
 }
 
-void CocoaDelay::UpdateWritePosition()
+void CocoaDelay::ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames)
 {
-	writePosition += 1;
-	writePosition %= std::size(bufferL);
+	ScopedFlushDenormals flushDenormals;
+	if (parametersChanged.exchange(false, std::memory_order_acquire)) UpdateEngineParameters();
+	engine.SetTempo(GetTempo());
+	engine.Process(inputs, outputs, nFrames);
 }
 
-void CocoaDelay::UpdateParameters()
+void CocoaDelay::Reset()
 {
-	// pan mode fadeout
-	if (currentPanMode != (PanModes)(int)GetParam(Parameters::panMode)->Value())
-	{
-		parameterChangeVolume -= 100.0 * dt;
-		if (parameterChangeVolume <= 0.0)
-		{
-			parameterChangeVolume = 0.0;
-			currentPanMode = (PanModes)(int)GetParam(Parameters::panMode)->Value();
-		}
-	}
-	else if (parameterChangeVolume < 1.0)
-	{
-		parameterChangeVolume += 100.0 * dt;
-		if (parameterChangeVolume > 1.0) parameterChangeVolume = 1.0;
-	}
+	TRACE;
+	IMutexLock lock(this);
+	if (parametersChanged.exchange(false, std::memory_order_acquire)) UpdateEngineParameters();
 
-	// pan amount smoothing
-	auto panAmount = GetParam(Parameters::pan)->Value();
-	auto stationaryPanAmountTarget = (currentPanMode == PanModes::stationary || currentPanMode == PanModes::pingPong) ? panAmount : 0.0;
-	stationaryPanAmount += (stationaryPanAmountTarget - stationaryPanAmount) * 100.0 * dt;
-	auto circularPanAmountTarget = (currentPanMode == PanModes::circular ? panAmount : 0.0);
-	circularPanAmount += (circularPanAmountTarget - circularPanAmount) * 100.0 * dt;
-}
+	// with reproducible drift on, the drift noise restarts from the seed on every
+	// reset, so offline renders of the same project come out identical
+	auto config = engine.GetConfig();
+	config.reproducible = GetParameterValue(Parameters::reproducibleDrift) >= .5;
+	config.seed = (uint64_t)GetParameterValue(Parameters::driftSeed);
+	engine.SetConfig(config);
 
-void CocoaDelay::UpdateDucking(double input)
-{
-	auto attackSpeed = GetParam(Parameters::duckAttackSpeed)->Value();
-	auto releaseSpeed = GetParam(Parameters::duckReleaseSpeed)->Value();
-	auto speed = duckFollower < abs(input) ? attackSpeed : releaseSpeed;
-	duckFollower += (abs(input) - duckFollower) * speed * dt;
+	// the tape is sized for the tempo at the time of the reset
+	engine.SetTempo(GetTempo(), false);
+	engine.Reset(GetSampleRate());
 }
 
-void CocoaDelay::UpdateLfo()
+// this can be called from any thread, including the audio thread and the ui thread
+// while audio is running, so it doesn't take the lock. the new value is handed over
+// through an atomic, and the audio thread picks it up at the start of the next block
+void CocoaDelay::OnParamChange(int paramIdx)
 {
-	lfoPhase += GetParam(Parameters::lfoFrequency)->Value() * dt;
-	while (lfoPhase > 1.0) lfoPhase -= 1.0;
+	parameterValues[paramIdx].store(IPlug::GetParam(paramIdx)->Value(), std::memory_order_relaxed);
+	parametersChanged.store(true, std::memory_order_release);
+	grayOutChanged.store(true, std::memory_order_release);
 }
 
-void CocoaDelay::UpdateDrift()
+void CocoaDelay::OnGUIIdle()
 {
-	auto driftSpeed = GetParam(Parameters::driftSpeed)->Value();
-	driftVelocity += random() * 10000.0 * driftSpeed * dt;
-	driftVelocity -= driftVelocity * 2.0 * sqrt(driftSpeed) * dt;
-	driftPhase += driftVelocity * dt;
+	if (grayOutChanged.exchange(false, std::memory_order_acquire)) UpdateGrayOut();
 }
 
-double CocoaDelay::GetSample(std::vector<double> &buffer, double position)
+// grays out the knobs that don't do anything with the current settings
+void CocoaDelay::UpdateGrayOut()
 {
-	int p0 = wrap(floor(position) - 1, 0, std::size(buffer) - 1);
-	int p1 = wrap(floor(position), 0, std::size(buffer) - 1);
-	int p2 = wrap(ceil(position), 0, std::size(buffer) - 1);
-	int p3 = wrap(ceil(position) + 1, 0, std::size(buffer) - 1);
+	auto tempoSyncTime = (TempoSyncTimes)(int)GetParameterValue(Parameters::tempoSyncTime);
+	pGraphics->GetControl(1)->GrayOut(tempoSyncTime != TempoSyncTimes::tempoSyncOff);
 
-	auto x = position - floor(position);
-	auto y0 = buffer[p0];
-	auto y1 = buffer[p1];
-	auto y2 = buffer[p2];
-	auto y3 = buffer[p3];
+	pGraphics->GetControl(4)->GrayOut(GetParameterValue(Parameters::lfoAmount) == 0.0);
+	pGraphics->GetControl(6)->GrayOut(GetParameterValue(Parameters::driftAmount) == 0.0);
 
-	return interpolate(x, y0, y1, y2, y3);
-}
+	auto duckingEnabled = GetParameterValue(Parameters::duckAmount) > 0.0;
+	pGraphics->GetControl(12)->GrayOut(!duckingEnabled);
+	pGraphics->GetControl(13)->GrayOut(!duckingEnabled);
 
-void CocoaDelay::WriteToBuffer(double** inputs, int s, double outL, double outR)
-{
-	auto writeL = 0.0, writeR = 0.0;
-	writeL += inputs[0][s];
-	writeR += inputs[1][s];
-	adjustPanning(writeL, writeR, stationaryPanAmount * .5, writeL, writeR);
-	writeL += outL * GetParam(Parameters::feedback)->Value();
-	writeR += outR * GetParam(Parameters::feedback)->Value();
-	switch (currentPanMode)
-	{
-	case PanModes::pingPong:
-		bufferL[writePosition] = writeR * parameterChangeVolume;
-		bufferR[writePosition] = writeL * parameterChangeVolume;
-		break;
-	default:
-		bufferL[writePosition] = writeL * parameterChangeVolume;
-		bufferR[writePosition] = writeR * parameterChangeVolume;
-		break;
-	}
-}
-
-void CocoaDelay::ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames)
-{
-	for (int s = 0; s < nFrames; s++)
-	{
-		// workaround for daws like renoise that don't start processing until the effect receives an input.
-		// if it's the first sample to be processed, the read positions will be immediately set to their targets.
-		// this way, when you first start a project, each delay plugin doesn't have to "slide up" to the correct delay time.
-		switch (warmedUp)
-		{
-		case false:
-			GetReadPositions(readPositionL, readPositionR);
-			warmedUp = true;
-			break;
-		}
-
-		UpdateParameters();
-		UpdateReadPositions();
-		UpdateDucking(inputs[0][s] + inputs[1][s]);
-		UpdateLfo();
-		UpdateDrift();
-
-		// read from buffer
-		auto outL = GetSample(bufferL, writePosition - readPositionL);
-		auto outR = GetSample(bufferR, writePosition - readPositionR);
-
-		// circular panning
-		adjustPanning(outL, outR, circularPanAmount, outL, outR);
-
-		// filters
-		lp.Process(dt, outL, outR, GetParam(Parameters::lowPassCutoff)->Value());
-		hp.Process(dt, outL, outR, GetParam(Parameters::highPassCutoff)->Value(), true);
-
-		// drive
-		auto driveAmount = GetParam(Parameters::driveGain)->Value();
-		auto driveMix = GetParam(Parameters::driveMix)->Value();
-		if (driveAmount > 0)
-		{
-			auto iterations = (int)GetParam(Parameters::driveIterations)->Value();
-			for (int i = 0; i < iterations; i++)
-			{
-				outL = statefulDrive.Process(outL * driveAmount, driveMix) / driveAmount;
-				outR = statefulDrive.Process(outR * driveAmount, driveMix) / driveAmount;
-				driveFilter.Process(dt, outL, outR, GetParam(Parameters::driveCutoff)->Value(), outL, outR);
-			}
-		}
-
-		// write to buffer
-		WriteToBuffer(inputs, s, outL, outR);
-		UpdateWritePosition();
-
-		// output
-		auto dry = GetParam(Parameters::dryVolume)->Value();
-		auto wet = GetParam(Parameters::wetVolume)->Value();
-		auto duckValue = GetParam(Parameters::duckAmount)->Value() * duckFollower;
-		duckValue = duckValue > 1.0 ? 1.0 : duckValue;
-		wet *= 1.0 - duckValue;
-		outputs[0][s] = inputs[0][s] * dry + outL * wet;
-		outputs[1][s] = inputs[1][s] * dry + outR * wet;
-	}
-}
-
-void CocoaDelay::Reset()
-{
-	TRACE;
-	IMutexLock lock(this);
-	dt = 1.0 / GetSampleRate();
-	InitBuffer();
-}
-
-void CocoaDelay::OnParamChange(int paramIdx)
-{
-	IMutexLock lock(this);
-
-	switch ((Parameters)paramIdx)
-	{
-	case Parameters::filterMode:
-		lp.SetMode((FilterModes)(int)GetParam(Parameters::filterMode)->Value());
-		hp.SetMode((FilterModes)(int)GetParam(Parameters::filterMode)->Value());
-		break;
-	case Parameters::tempoSyncTime:
-	{
-		auto tempoSyncTime = (TempoSyncTimes)(int)GetParam(Parameters::tempoSyncTime)->Value();
-		pGraphics->GetControl(1)->GrayOut(tempoSyncTime != TempoSyncTimes::tempoSyncOff);
-		break;
-	}
-	case Parameters::lfoAmount:
-		pGraphics->GetControl(4)->GrayOut(GetParam(Parameters::lfoAmount)->Value() == 0.0);
-		break;
-	case Parameters::driftAmount:
-		pGraphics->GetControl(6)->GrayOut(GetParam(Parameters::driftAmount)->Value() == 0.0);
-		break;
-	case Parameters::duckAmount:
-	{
-		auto duckingEnabled = GetParam(Parameters::duckAmount)->Value() > 0.0;
-		pGraphics->GetControl(12)->GrayOut(!duckingEnabled);
-		pGraphics->GetControl(13)->GrayOut(!duckingEnabled);
-		break;
-	}
-	case Parameters::driveGain:
-	{
-		auto driveEnabled = GetParam(Parameters::driveGain)->Value() > 0.0;
-		pGraphics->GetControl(18)->GrayOut(!driveEnabled);
-		pGraphics->GetControl(19)->GrayOut(!driveEnabled);
-		pGraphics->GetControl(20)->GrayOut(!driveEnabled);
-		break;
-	}
-	}
+	auto driveEnabled = GetParameterValue(Parameters::driveGain) > 0.0;
+	pGraphics->GetControl(18)->GrayOut(!driveEnabled);
+	pGraphics->GetControl(19)->GrayOut(!driveEnabled);
+	pGraphics->GetControl(20)->GrayOut(!driveEnabled);
 }
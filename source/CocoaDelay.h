@@ -1,17 +1,17 @@
 #ifndef __COCOADELAY__
 #define __COCOADELAY__
 
-#include <cmath>
-#include "Filter.h"
+#include "engine/CocoaDelayEngine.h"
+#include "engine/Denormals.h"
+#include "engine/Util.h"
 #include "Knob.h"
 #include "PresetMenu.h"
-#include "StatefulDrive.h"
-#include "Util.h"
-#include <vector>
 #include "IPlug_include_in_plug_hdr.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 const int numPrograms = 128;
-const int tapeLength = 10;
 
 enum class Parameters
 {
@@ -37,42 +37,13 @@ enum class Parameters
 	driveIterations,
 	dryVolume,
 	wetVolume,
+	driveMode,
+	oversampling,
+	reproducibleDrift,
+	driftSeed,
 	numParameters
 };
 
-enum class TempoSyncTimes
-{
-	tempoSyncOff,
-	whole,
-	dottedHalf,
-	half,
-	tripletHalf,
-	dottedQuarter,
-	quarter,
-	tripletQuarter,
-	dottedEighth,
-	eighth,
-	tripletEighth,
-	dottedSixteenth,
-	sixteenth,
-	tripletSixteenth,
-	dottedThirtysecond,
-	thirtysecond,
-	tripletThirtysecond,
-	dottedSixtyforth,
-	sixtyforth,
-	tripletSixtyforth,
-	numTempoSyncTimes
-};
-
-enum class PanModes
-{
-	stationary,
-	pingPong,
-	circular,
-	numPanModes
-};
-
 class CocoaDelay : public IPlug
 {
 public:
@@ -82,54 +53,31 @@ public:
 	IParam* GetParam(Parameters p) { return IPlug::GetParam((int)p); }
 	void Reset();
 	void OnParamChange(int paramIdx);
+	void OnGUIIdle();
 	void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
 	void InitParameters();
 	void InitGraphics();
 	void InitPresets();
-	double GetDelayTime();
-	void GetReadPositions(double & l, double & r);
-	void InitBuffer();
-	void UpdateReadPositions();
-	void UpdateWritePosition();
-	void UpdateParameters();
-	void UpdateDucking(double input);
-	void UpdateLfo();
-	void UpdateDrift();
-	double GetSample(std::vector<double> &buffer, double position);
-	void WriteToBuffer(double** inputs, int s, double outL, double outR);
+	void UpdateEngineParameters();
+	void UpdateGrayOut();
+	void UpdateTape();
+	double GetParameterValue(Parameters p) const { return parameterValues[(int)p].load(std::memory_order_relaxed); }
 
 	IGraphics* pGraphics;
-	double dt = 0.0;
-
-	// delay
-	std::vector<double> bufferL;
-	std::vector<double> bufferR;
-	int writePosition;
-	double readPositionL;
-	double readPositionR;
-	bool warmedUp = false;
-
-	// fading parameters
-	PanModes currentPanMode = PanModes::stationary;
-	double parameterChangeVolume = 1.0;
-	double stationaryPanAmount = 0.0;
-	double circularPanAmount = 0.0;
-
-	// filters
-	MultiFilter lp;
-	MultiFilter hp;
+	CocoaDelayEngine engine;
 
-	// drive
-	StatefulDrive statefulDrive;
-	DualFilter<TwoPoleFilter> driveFilter;
+	// the latest value of each parameter, and flags for the audio
+	// and ui threads to tell them something has changed since they last looked
+	std::atomic<double> parameterValues[(int)Parameters::numParameters];
+	std::atomic<bool> parametersChanged{ true };
+	std::atomic<bool> grayOutChanged{ true };
 
-	// modulation
-	double duckFollower = 0.0;
-	double lfoPhase = 0.0;
-	double driftVelocity = 0.0;
-	double driftPhase = 0.0;
+	// grows the engine's tape off the audio thread if the host slows down.
+	// it runs whether or not the ui is open, so it can't be done in OnGUIIdle
+	std::atomic<bool> updatingTape{ true };
+	std::thread tapeThread;
 };
 
-#endif
+#endif
\ No newline at end of file
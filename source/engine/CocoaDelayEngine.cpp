@@ -0,0 +1,848 @@
+#include "CocoaDelayEngine.h"
+#include "Util.h"
+#include <limits>
+
+void CocoaDelayEngine::Reset(double sampleRate)
+{
+	this->sampleRate = sampleRate > 0.0 ? sampleRate : 44100.0;
+	dt = 1.0 / this->sampleRate;
+	ResetRamps();
+	ResetState();
+	InitBuffer();
+}
+
+void CocoaDelayEngine::SetParameters(const EngineParameters &p)
+{
+	for (auto &pair : pairs)
+	{
+		if (p.oversampling != parameters.oversampling) pair.oversampler.Init(p.oversampling);
+		pair.lp.SetMode(p.filterMode);
+		pair.hp.SetMode(p.filterMode);
+	}
+	parameters = p;
+}
+
+void CocoaDelayEngine::SetTempo(double bpm, bool ramp)
+{
+	if (bpm <= 0.0) return;
+	if (!ramp) beatLengthRamp.Reset(60 / bpm);
+
+	// asks UpdateTape for a longer tape if this tempo needs one
+	if (bpm != tempo || !tempoKnown)
+	{
+		auto length = GetTapeLength(bpm);
+		if (length > pairs[0].tape.GetLength()) tapeGrowth->requestedLength.store(length, std::memory_order_relaxed);
+	}
+	tempo = bpm;
+	tempoKnown = true;
+}
+
+void CocoaDelayEngine::UpdateTape()
+{
+	auto &growth = *tapeGrowth;
+	std::lock_guard<std::mutex> lock(growth.mutex);
+	auto state = growth.state.load(std::memory_order_acquire);
+	if (state == TapeGrowth::State::ready) return;
+	if (state == TapeGrowth::State::swapped)
+	{
+		// frees the old tapes GrowTape left behind
+		for (auto &tape : growth.tapes) tape = Tape();
+		growth.state.store(TapeGrowth::State::idle, std::memory_order_relaxed);
+	}
+
+	auto length = growth.requestedLength.load(std::memory_order_relaxed);
+	if (length <= growth.length) return;
+	for (int p = 0; p < numPairs; p++)
+		growth.tapes[p].Init(length, growth.layout, growth.precision, pairs[p].mono ? 1 : 2);
+	growth.length = growth.tapes[0].GetLength();
+	growth.state.store(TapeGrowth::State::ready, std::memory_order_release);
+}
+
+// moves over to the longer tapes from UpdateTape once they're ready. what's on the
+// old tapes is copied across a bit each block, oldest first, along with whatever
+// was written since, and the new tapes are swapped in once they've caught up.
+// every frame lands where it would have been written on the longer tape, so it's
+// still the same distance behind the write position after the swap
+void CocoaDelayEngine::GrowTape(int nFrames)
+{
+	auto &growth = *tapeGrowth;
+	if (growth.state.load(std::memory_order_acquire) != TapeGrowth::State::ready) return;
+
+	// anything the old tapes have written over since is too old to need
+	auto oldLength = (uint64_t)pairs[0].tape.GetLength();
+	auto oldest = framesWritten > oldLength ? framesWritten - oldLength : 0;
+	if (!growth.copying || growth.copyPosition < oldest) growth.copyPosition = oldest;
+	growth.copying = true;
+
+	auto count = (uint64_t)tapeCopyLength + nFrames;
+	if (count > framesWritten - growth.copyPosition) count = framesWritten - growth.copyPosition;
+	for (int p = 0; p < numPairs; p++)
+		growth.tapes[p].CopyFrames(pairs[p].tape, growth.copyPosition, (int)count);
+	growth.copyPosition += count;
+	if (growth.copyPosition < framesWritten) return;
+
+	for (int p = 0; p < numPairs; p++) std::swap(pairs[p].tape, growth.tapes[p]);
+	writePosition = (int)(framesWritten & (uint64_t)pairs[0].tape.GetMask());
+	growth.copying = false;
+	growth.state.store(TapeGrowth::State::swapped, std::memory_order_release);
+}
+
+double CocoaDelayEngine::GetBaseDelayTime(const EngineParameters &parameters, double beatLength)
+{
+	double delayTime = 0.0;
+	switch (parameters.tempoSyncTime)
+	{
+	case TempoSyncTimes::tempoSyncOff:
+		delayTime = parameters.delayTime;
+		break;
+	case TempoSyncTimes::whole:               delayTime = beatLength * 4;    break;
+	case TempoSyncTimes::dottedHalf:          delayTime = beatLength * 3;    break;
+	case TempoSyncTimes::half:                delayTime = beatLength * 2;    break;
+	case TempoSyncTimes::tripletHalf:         delayTime = beatLength * 4/3;  break;
+	case TempoSyncTimes::dottedQuarter:       delayTime = beatLength * 3/2;  break;
+	case TempoSyncTimes::quarter:             delayTime = beatLength * 1;    break;
+	case TempoSyncTimes::tripletQuarter:      delayTime = beatLength * 2/3;  break;
+	case TempoSyncTimes::dottedEighth:        delayTime = beatLength * 3/4;  break;
+	case TempoSyncTimes::eighth:              delayTime = beatLength * 1/2;  break;
+	case TempoSyncTimes::tripletEighth:       delayTime = beatLength * 1/3;  break;
+	case TempoSyncTimes::dottedSixteenth:     delayTime = beatLength * 3/8;  break;
+	case TempoSyncTimes::sixteenth:           delayTime = beatLength * 1/4;  break;
+	case TempoSyncTimes::tripletSixteenth:    delayTime = beatLength * 1/6;  break;
+	case TempoSyncTimes::dottedThirtysecond:  delayTime = beatLength * 3/16; break;
+	case TempoSyncTimes::thirtysecond:        delayTime = beatLength * 1/8;  break;
+	case TempoSyncTimes::tripletThirtysecond: delayTime = beatLength * 1/12; break;
+	case TempoSyncTimes::dottedSixtyforth:    delayTime = beatLength * 3/32; break;
+	case TempoSyncTimes::sixtyforth:          delayTime = beatLength * 1/16; break;
+	case TempoSyncTimes::tripletSixtyforth:   delayTime = beatLength * 1/24; break;
+	default:                                  delayTime = parameters.delayTime; break;
+	}
+	return delayTime;
+}
+
+// lookahead projects the lfo and drift phases that many samples into the future
+double CocoaDelayEngine::GetDelayTime(int lookahead)
+{
+	auto delayTime = GetBaseDelayTime(parameters, beatLengthRamp.Get(lookahead));
+
+	// modulation
+	auto lfoAmount = parameters.lfoAmount;
+	auto lfo = lfoPhase + parameters.lfoFrequency * dt * lookahead;
+	if (lfoAmount != 0.0) delayTime = pow(delayTime, 1.0 + lfoAmount * sin(lfo * 2 * Util::pi));
+	auto driftAmount = parameters.driftAmount;
+	auto drift = driftPhase + driftVelocity * dt * lookahead;
+	if (driftAmount != 0.0) delayTime = pow(delayTime, 1.0 + driftAmount * sin(drift));
+
+	return delayTime;
+}
+
+void CocoaDelayEngine::GetReadPositions(double &l, double &r, int lookahead)
+{
+	auto offset = parameters.stereoOffset * .5;
+	auto baseTime = GetDelayTime(lookahead);
+	auto timeL = pow(baseTime, 1.0 + offset);
+	auto timeR = pow(baseTime, 1.0 - offset);
+	l = CompensateLatency(timeL * sampleRate);
+	r = CompensateLatency(timeR * sampleRate);
+
+	// if the host has slowed down since the tape was sized, a synced delay can reach
+	// further back than the tape goes until UpdateTape has made a longer one, so the
+	// reads are held at the oldest samples it has. the interpolator reads one sample
+	// further back than the read position, and the tape keeps a few samples spare
+	auto maxReadPosition = pairs[0].tape.GetMask() - 3.0;
+	l = l < maxReadPosition ? l : maxReadPosition;
+	r = r < maxReadPosition ? r : maxReadPosition;
+}
+
+// the oversampler delays everything that goes through the drive, so the tape is
+// read that much closer to the write position to keep the echoes in time. delays
+// shorter than the latency can only be brought down to a few samples. the
+// antialiased drive doesn't add any latency of its own, see ProcessAntialiased
+double CocoaDelayEngine::CompensateLatency(double readPosition)
+{
+	const double minReadPosition = 3.0;
+	auto latency = pairs[0].oversampler.GetLatency();
+	if (latency == 0.0) return readPosition;
+	auto compensated = readPosition - latency;
+	if (compensated > minReadPosition) return compensated;
+	return readPosition < minReadPosition ? readPosition : minReadPosition;
+}
+
+// the lfo, drift and stereo offset each raise the delay time to a power, so the
+// exponents multiply. delays over a second get longest with the largest exponent,
+// and shorter delays get longest with the smallest one
+double CocoaDelayEngine::GetMaxDelayTime(const EngineParameters &parameters, double tempo)
+{
+	auto baseTime = GetBaseDelayTime(parameters, 60 / tempo);
+	auto offset = fabs(parameters.stereoOffset) * .5;
+	auto exponent = baseTime > 1.0
+		? (1.0 + parameters.lfoAmount) * (1.0 + parameters.driftAmount) * (1.0 + offset)
+		: (1.0 - parameters.lfoAmount) * (1.0 - parameters.driftAmount) * (1.0 - offset);
+	auto maxTime = pow(baseTime, exponent);
+	return maxTime < maxTapeLength ? maxTime : maxTapeLength;
+}
+
+// the longest delay that any settings within the front ends' ranges can reach
+// at this tempo. the longest base delay is either the delay time knob at its
+// maximum or a whole note, and the modulation stretches it furthest at full depth
+double CocoaDelayEngine::GetLongestDelayTime(double tempo)
+{
+	EngineParameters longest;
+	longest.delayTime = fmax(maxDelayTime, 4 * 60 / tempo);
+	longest.lfoAmount = maxLfoAmount;
+	longest.driftAmount = maxDriftAmount;
+	longest.stereoOffset = maxStereoOffset;
+	return GetMaxDelayTime(longest, tempo);
+}
+
+// how much tape the longest delay at this tempo needs, with the same few
+// extra samples as GetRequiredTapeLength
+size_t CocoaDelayEngine::GetTapeLength(double tempo)
+{
+	return (size_t)(GetLongestDelayTime(tempo) * sampleRate) + 4;
+}
+
+// how much of the tape the current settings can read back, in samples. the
+// interpolator reads one sample further back than the delay time, so a few
+// extra samples are needed on top of the longest delay
+size_t CocoaDelayEngine::GetRequiredTapeLength()
+{
+	auto length = (size_t)(GetMaxDelayTime(parameters, tempo) * sampleRate) + 4;
+	auto tapeLength = pairs[0].tape.GetLength();
+	return length < tapeLength ? length : tapeLength;
+}
+
+// how long a full scale echo takes to die away below the silence threshold, going
+// by the feedback alone. the filters and the drive don't add any gain on the way
+double CocoaDelayEngine::GetTailLength(const EngineParameters &parameters, double tempo)
+{
+	auto feedback = fabs(parameters.feedback);
+	if (feedback >= 1.0) return std::numeric_limits<double>::infinity();
+	auto repeats = 1.0;
+	if (feedback > silenceThreshold) repeats += ceil(log(silenceThreshold) / log(feedback));
+	return GetMaxDelayTime(parameters, tempo > 0.0 ? tempo : 120.0) * repeats;
+}
+
+// uses the config's channel groups if they cover every channel exactly once,
+// otherwise the channels are paired in order
+void CocoaDelayEngine::InitChannelGroups()
+{
+	bool used[maxChannels] = {};
+	auto numUsed = 0;
+	auto valid = config.numChannelGroups > 0 && config.numChannelGroups <= numChannels;
+	for (int g = 0; valid && g < config.numChannelGroups; g++)
+	{
+		auto &group = config.channelGroups[g];
+		for (int lane = 0; valid && lane < (group.right == -1 ? 1 : 2); lane++)
+		{
+			auto channel = lane == 0 ? group.left : group.right;
+			valid = channel >= 0 && channel < numChannels && !used[channel];
+			if (valid)
+			{
+				used[channel] = true;
+				numUsed++;
+			}
+		}
+	}
+	valid = valid && numUsed == numChannels;
+
+	numPairs = 0;
+	if (valid)
+	{
+		for (int g = 0; g < config.numChannelGroups; g++)
+		{
+			pairs[numPairs].channels[0] = config.channelGroups[g].left;
+			pairs[numPairs].channels[1] = config.channelGroups[g].right;
+			numPairs++;
+		}
+	}
+	else
+	{
+		for (int c = 0; c < numChannels; c += 2)
+		{
+			pairs[numPairs].channels[0] = c;
+			pairs[numPairs].channels[1] = c + 1 < numChannels ? c + 1 : -1;
+			numPairs++;
+		}
+	}
+	for (int p = 0; p < numPairs; p++) pairs[p].mono = pairs[p].channels[1] == -1;
+}
+
+void CocoaDelayEngine::InitBuffer()
+{
+	// UpdateTape reads the channel layout, so it has to wait until the new one is set up
+	auto &growth = *tapeGrowth;
+	std::lock_guard<std::mutex> lock(growth.mutex);
+	numChannels = config.numChannels < 1 ? 1 : config.numChannels > maxChannels ? maxChannels : config.numChannels;
+	InitChannelGroups();
+
+	// this and UpdateTape are the only places the tape is allocated, so that nothing
+	// the parameters or the tempo do can allocate on the audio thread. until the host
+	// has given a tempo, there's no telling how long a synced delay can get
+	auto length = tempoKnown ? GetTapeLength(tempo) : (size_t)(maxTapeLength * sampleRate) + 4;
+	for (int p = 0; p < maxChannels; p++)
+	{
+		auto &pair = pairs[p];
+		if (p >= numPairs)
+		{
+			// frees the tapes of pairs that aren't used anymore
+			pair.tape = Tape();
+			continue;
+		}
+		pair.tape.Init(length, config.tapeLayout, config.tapePrecision, pair.mono ? 1 : 2);
+		for (auto &sample : pair.in[1]) sample = 0.0;
+	}
+
+	// anything UpdateTape made for the old settings is no use anymore
+	for (auto &tape : growth.tapes) tape = Tape();
+	growth.state.store(TapeGrowth::State::idle, std::memory_order_relaxed);
+	growth.requestedLength.store(0, std::memory_order_relaxed);
+	growth.length = pairs[0].tape.GetLength();
+	growth.layout = config.tapeLayout;
+	growth.precision = config.tapePrecision;
+	growth.copying = false;
+	writePosition = 0;
+	framesWritten = 0;
+	quietSamples = 0;
+	idle = false;
+	ResetReadPositions();
+}
+
+void CocoaDelayEngine::ResetReadPositions()
+{
+	GetReadPositions(readPositionL, readPositionR);
+	targetReadPositionL = nextReadPositionL = readPositionL;
+	targetReadPositionR = nextReadPositionR = readPositionR;
+	targetStepL = targetStepR = 0.0;
+	modulationCounter = 0;
+}
+
+void CocoaDelayEngine::ResetRamps()
+{
+	feedback.Reset(parameters.feedback);
+	lowPassCutoff.Reset(parameters.lowPassCutoff);
+	highPassCutoff.Reset(parameters.highPassCutoff);
+	driveGain.Reset(parameters.driveGain);
+	driveMix.Reset(parameters.driveMix);
+	driveCutoff.Reset(parameters.driveCutoff);
+	duckAmount.Reset(parameters.duckAmount);
+	dryVolume.Reset(parameters.dryVolume);
+	wetVolume.Reset(parameters.wetVolume);
+	beatLengthRamp.Reset(60 / tempo);
+}
+
+// puts everything that carries over from one sample to the next back where it
+// started, apart from the tape and read positions, which InitBuffer takes care of
+void CocoaDelayEngine::ResetState()
+{
+	currentPanMode = parameters.panMode;
+	parameterChangeVolume = 1.0;
+	stationaryPanAmount = (currentPanMode == PanModes::stationary || currentPanMode == PanModes::pingPong) ? parameters.pan : 0.0;
+	circularPanAmount = currentPanMode == PanModes::circular ? parameters.pan : 0.0;
+	for (auto &pair : pairs)
+	{
+		pair.lp.Reset();
+		pair.hp.Reset();
+		pair.statefulDrive.Reset();
+		pair.driveFilter.Reset();
+		pair.oversampler.Reset();
+	}
+	duckFollower = 0.0;
+	lfoPhase = 0.0;
+	driftVelocity = 0.0;
+	driftPhase = 0.0;
+	if (config.reproducible) random.Seed(config.seed);
+	warmedUp = false;
+}
+
+void CocoaDelayEngine::StartRamps(int nFrames)
+{
+	feedback.Start(parameters.feedback, nFrames);
+	lowPassCutoff.Start(parameters.lowPassCutoff, nFrames);
+	highPassCutoff.Start(parameters.highPassCutoff, nFrames);
+	driveGain.Start(parameters.driveGain, nFrames);
+	driveMix.Start(parameters.driveMix, nFrames);
+	driveCutoff.Start(parameters.driveCutoff, nFrames);
+	duckAmount.Start(parameters.duckAmount, nFrames);
+	dryVolume.Start(parameters.dryVolume, nFrames);
+	wetVolume.Start(parameters.wetVolume, nFrames);
+	beatLengthRamp.Start(60 / tempo, nFrames);
+}
+
+void CocoaDelayEngine::FinishRamps()
+{
+	feedback.Finish();
+	lowPassCutoff.Finish();
+	highPassCutoff.Finish();
+	driveGain.Finish();
+	driveMix.Finish();
+	driveCutoff.Finish();
+	duckAmount.Finish();
+	dryVolume.Finish();
+	wetVolume.Finish();
+	beatLengthRamp.Finish();
+}
+
+void CocoaDelayEngine::UpdateReadPositions()
+{
+	if (modulationCounter <= 0)
+	{
+		// start the next segment where the last one was supposed to end,
+		// so rounding errors in the steps don't pile up. the end of the
+		// segment is evaluated ahead of time so the modulation doesn't lag
+		auto interval = config.modulationInterval > 1 ? config.modulationInterval : 1;
+		targetReadPositionL = nextReadPositionL;
+		targetReadPositionR = nextReadPositionR;
+		GetReadPositions(nextReadPositionL, nextReadPositionR, interval - 1);
+		targetStepL = (nextReadPositionL - targetReadPositionL) / interval;
+		targetStepR = (nextReadPositionR - targetReadPositionR) / interval;
+		modulationCounter = interval;
+	}
+	modulationCounter--;
+	targetReadPositionL += targetStepL;
+	targetReadPositionR += targetStepR;
+
+	readPositionL += (targetReadPositionL - readPositionL) * 10.0 * dt;
+	readPositionR += (targetReadPositionR - readPositionR) * 10.0 * dt;
+}
+
+// writePosition stays at the start of the chunk until the whole chunk is written
+int CocoaDelayEngine::GetWritePosition(int i)
+{
+	return (writePosition + i) & pairs[0].tape.GetMask();
+}
+
+void CocoaDelayEngine::UpdateWritePosition(int n)
+{
+	writePosition = (writePosition + n) & pairs[0].tape.GetMask();
+	framesWritten += n;
+}
+
+void CocoaDelayEngine::UpdateParameters()
+{
+	// pan mode fadeout
+	if (currentPanMode != parameters.panMode)
+	{
+		parameterChangeVolume -= 100.0 * dt;
+		if (parameterChangeVolume <= 0.0)
+		{
+			parameterChangeVolume = 0.0;
+			currentPanMode = parameters.panMode;
+		}
+	}
+	else if (parameterChangeVolume < 1.0)
+	{
+		parameterChangeVolume += 100.0 * dt;
+		if (parameterChangeVolume > 1.0) parameterChangeVolume = 1.0;
+	}
+
+	// pan amount smoothing
+	auto panAmount = parameters.pan;
+	auto stationaryPanAmountTarget = (currentPanMode == PanModes::stationary || currentPanMode == PanModes::pingPong) ? panAmount : 0.0;
+	stationaryPanAmount += (stationaryPanAmountTarget - stationaryPanAmount) * 100.0 * dt;
+	auto circularPanAmountTarget = (currentPanMode == PanModes::circular ? panAmount : 0.0);
+	circularPanAmount += (circularPanAmountTarget - circularPanAmount) * 100.0 * dt;
+}
+
+void CocoaDelayEngine::UpdateDucking(double input)
+{
+	auto attackSpeed = parameters.duckAttackSpeed;
+	auto releaseSpeed = parameters.duckReleaseSpeed;
+	auto speed = duckFollower < fabs(input) ? attackSpeed : releaseSpeed;
+	duckFollower += (fabs(input) - duckFollower) * speed * dt;
+}
+
+void CocoaDelayEngine::UpdateLfo()
+{
+	lfoPhase += parameters.lfoFrequency * dt;
+	while (lfoPhase > 1.0) lfoPhase -= 1.0;
+}
+
+void CocoaDelayEngine::UpdateDrift()
+{
+	auto driftSpeed = parameters.driftSpeed;
+	driftVelocity += random.Bipolar() * 10000.0 * driftSpeed * dt;
+	driftVelocity -= driftVelocity * 2.0 * sqrt(driftSpeed) * dt;
+	driftPhase += driftVelocity * dt;
+}
+
+// copies the next n samples of each channel into its pair's lane
+template<class T>
+void CocoaDelayEngine::ReadChunkInput(const T* const* inputs, int offset, int n, bool monoInput)
+{
+	for (int p = 0; p < numPairs; p++)
+	{
+		for (int lane = 0; lane < (pairs[p].mono ? 1 : 2); lane++)
+		{
+			auto input = inputs[monoInput ? 0 : pairs[p].channels[lane]];
+			auto in = pairs[p].in[lane];
+			for (int i = 0; i < n; i++) in[i] = input[offset + i];
+		}
+	}
+}
+
+// works out everything that doesn't depend on the audio for the next n samples
+template<class T>
+void CocoaDelayEngine::PrepareChunk(const T* const* inputs, int offset, int n, bool monoInput)
+{
+	// read the inputs up front so processing can happen in place
+	ReadChunkInput(inputs, offset, n, monoInput);
+
+	// the panning is the same for every pair, so the rotations are worked out once
+	auto panning = false;
+	for (int p = 0; p < numPairs; p++) panning = panning || !pairs[p].mono;
+	for (int i = 0; i < n; i++)
+	{
+		beatLengthRamp.Next();
+
+		// workaround for daws like renoise that don't start processing until the effect receives an input.
+		// if it's the first sample to be processed, the read positions will be immediately set to their targets.
+		// this way, when you first start a project, each delay plugin doesn't have to "slide up" to the correct delay time.
+		switch (warmedUp)
+		{
+		case false:
+			ResetReadPositions();
+			warmedUp = true;
+			break;
+		}
+
+		auto duckInput = 0.0;
+		if (monoInput)
+			duckInput = pairs[0].in[0][i];
+		else
+			for (int p = 0; p < numPairs; p++) duckInput += pairs[p].in[0][i] + pairs[p].in[1][i];
+
+		UpdateParameters();
+		UpdateReadPositions();
+		UpdateDucking(duckInput);
+		UpdateLfo();
+		UpdateDrift();
+
+		chunk.readPositionL[i] = readPositionL;
+		chunk.readPositionR[i] = readPositionR;
+		chunk.panMode[i] = currentPanMode;
+		chunk.parameterChangeVolume[i] = parameterChangeVolume;
+		if (panning)
+		{
+			chunk.stationaryPanCos[i] = cos(stationaryPanAmount * .5);
+			chunk.stationaryPanSin[i] = sin(stationaryPanAmount * .5);
+			chunk.circularPanCos[i] = cos(circularPanAmount);
+			chunk.circularPanSin[i] = sin(circularPanAmount);
+		}
+		chunk.duckFollower[i] = duckFollower;
+	}
+	feedback.Fill(chunk.feedback, n);
+	chunk.lowPassCutoffMoving = lowPassCutoff.IsMoving();
+	chunk.highPassCutoffMoving = highPassCutoff.IsMoving();
+	lowPassCutoff.Fill(chunk.lowPassCutoff, n);
+	highPassCutoff.Fill(chunk.highPassCutoff, n);
+	driveGain.Fill(chunk.driveGain, n);
+	driveMix.Fill(chunk.driveMix, n);
+	driveCutoff.Fill(chunk.driveCutoff, n);
+	duckAmount.Fill(chunk.duckAmount, n);
+	dryVolume.Fill(chunk.dryVolume, n);
+	wetVolume.Fill(chunk.wetVolume, n);
+}
+
+// true if none of the chunk's reads touch samples written earlier in the same
+// chunk, in which case all of the reads can happen before any of the writes.
+// the interpolator reads up to two samples ahead of the read position
+bool CocoaDelayEngine::IsChunkIndependent(int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (chunk.readPositionL[i] <= i + 2 || chunk.readPositionL[i] >= pairs[0].tape.GetMask()) return false;
+		if (chunk.readPositionR[i] <= i + 2 || chunk.readPositionR[i] >= pairs[0].tape.GetMask()) return false;
+	}
+	return true;
+}
+
+// the usual case, where the delay is longer than the chunk. each stage runs
+// over the whole chunk before the next one starts
+void CocoaDelayEngine::ProcessChunk(ChannelPair &pair, int n)
+{
+	for (int i = 0; i < n; i++) ReadFromBuffer(pair, i);
+	if (chunk.lowPassCutoffMoving)
+		pair.lp.Process(dt, pair.out[0], pair.out[1], n, chunk.lowPassCutoff);
+	else
+		pair.lp.Process(dt, pair.out[0], pair.out[1], n, chunk.lowPassCutoff[0]);
+	if (chunk.highPassCutoffMoving)
+		pair.hp.Process(dt, pair.out[0], pair.out[1], n, chunk.highPassCutoff);
+	else
+		pair.hp.Process(dt, pair.out[0], pair.out[1], n, chunk.highPassCutoff[0]);
+	for (int i = 0; i < n; i++) Drive(pair, i);
+	for (int i = 0; i < n; i++) WriteToBuffer(pair, i);
+}
+
+// short delays read back what was just written, so each sample has to go
+// all the way through the chain before the next one
+void CocoaDelayEngine::ProcessChunkBySample(ChannelPair &pair, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		ReadFromBuffer(pair, i);
+		pair.lp.Process(dt, pair.out[0][i], pair.out[1][i], chunk.lowPassCutoff[i]);
+		pair.hp.Process(dt, pair.out[0][i], pair.out[1][i], chunk.highPassCutoff[i]);
+		Drive(pair, i);
+		WriteToBuffer(pair, i);
+	}
+}
+
+template<class T>
+void CocoaDelayEngine::WriteChunkOutput(T* const* outputs, int offset, int n, bool monoOutput)
+{
+	double wet[maxChunkLength];
+	for (int i = 0; i < n; i++)
+	{
+		auto duckValue = chunk.duckAmount[i] * chunk.duckFollower[i];
+		duckValue = duckValue > 1.0 ? 1.0 : duckValue;
+		wet[i] = chunk.wetVolume[i] * (1.0 - duckValue);
+	}
+	for (int p = 0; p < numPairs; p++)
+	{
+		for (int lane = 0; lane < (pairs[p].mono ? 1 : 2); lane++)
+		{
+			auto c = pairs[p].channels[lane];
+			if (monoOutput && c != 0) continue;
+			auto in = pairs[p].in[lane];
+			auto out = pairs[p].out[lane];
+			for (int i = 0; i < n; i++)
+				outputs[c][offset + i] = (T)(in[i] * chunk.dryVolume[i] + out[i] * wet[i]);
+		}
+	}
+}
+
+// reads chunk sample i from the pair's tape and applies the circular panning
+void CocoaDelayEngine::ReadFromBuffer(ChannelPair &pair, int i)
+{
+	auto position = GetWritePosition(i);
+	if (pair.mono)
+	{
+		pair.out[0][i] = pair.tape.Read(0, position - chunk.readPositionL[i]);
+		pair.out[1][i] = 0.0;
+		return;
+	}
+	auto outL = pair.tape.Read(0, position - chunk.readPositionL[i]);
+	auto outR = pair.tape.Read(1, position - chunk.readPositionR[i]);
+	Util::rotate(outL, outR, chunk.circularPanCos[i], chunk.circularPanSin[i], outL, outR);
+	pair.out[0][i] = outL;
+	pair.out[1][i] = outR;
+}
+void CocoaDelayEngine::Drive(ChannelPair &pair, int i)
+{
+	auto driveAmount = chunk.driveGain[i];
+	auto input = Double2(pair.out[0][i], pair.out[1][i]);
+	auto filterCoefficient = GetCutoffCoefficient(dt, chunk.driveCutoff[i]);
+	Double2 out;
+	auto factor = pair.oversampler.GetFactor();
+	if (factor == 1)
+	{
+		if (driveAmount <= 0) return;
+		out = Drive(pair, input, i, filterCoefficient);
+	}
+	else
+	{
+		// the read positions make up for the oversampler's latency,
+		// so the signal has to go through it even when the drive is off
+		Double2 samples[Oversampler::maxFactor];
+		pair.oversampler.Upsample(input, samples);
+		if (driveAmount > 0)
+		{
+			// puts the filter's poles in the same place they'd be at the original rate,
+			// so the drive sounds the same apart from the aliasing
+			filterCoefficient = 1.0 - pow(1.0 - filterCoefficient, 1.0 / factor);
+			for (int j = 0; j < factor; j++)
+				samples[j] = Drive(pair, samples[j], i, filterCoefficient);
+		}
+		out = pair.oversampler.Downsample(samples);
+	}
+	pair.out[0][i] = out.Left();
+	pair.out[1][i] = out.Right();
+}
+
+// runs one sample through the drive iterations, using the drive parameters for chunk sample i
+Double2 CocoaDelayEngine::Drive(ChannelPair &pair, Double2 input, int i, double filterCoefficient)
+{
+	auto driveAmount = chunk.driveGain[i];
+	auto driveMixAmount = chunk.driveMix[i];
+	auto inverseDriveAmount = 1.0 / driveAmount;
+	auto out = input;
+	auto iterations = parameters.driveIterations < StatefulDrive::maxStages ? parameters.driveIterations : StatefulDrive::maxStages;
+	auto antialiased = parameters.driveMode == DriveModes::antialiased;
+	for (int j = 0; j < iterations; j++)
+	{
+		out = antialiased
+			? pair.statefulDrive.ProcessAntialiased(out * driveAmount, driveMixAmount, j)
+			: pair.statefulDrive.Process(out * driveAmount, driveMixAmount, j);
+		out *= inverseDriveAmount;
+		out = pair.driveFilter.Tick(out, filterCoefficient, false);
+	}
+	return out;
+}
+
+void CocoaDelayEngine::WriteToBuffer(ChannelPair &pair, int i)
+{
+	// the pan mode fade is only there to hide the channels swapping over
+	if (pair.mono)
+	{
+		pair.tape.Write(GetWritePosition(i), pair.in[0][i] + pair.out[0][i] * chunk.feedback[i]);
+		return;
+	}
+	auto writeL = pair.in[0][i];
+	auto writeR = pair.in[1][i];
+	Util::rotate(writeL, writeR, chunk.stationaryPanCos[i], chunk.stationaryPanSin[i], writeL, writeR);
+	writeL += pair.out[0][i] * chunk.feedback[i];
+	writeR += pair.out[1][i] * chunk.feedback[i];
+	auto volume = chunk.parameterChangeVolume[i];
+	switch (chunk.panMode[i])
+	{
+	case PanModes::pingPong:
+		pair.tape.Write(GetWritePosition(i), writeR * volume, writeL * volume);
+		break;
+	default:
+		pair.tape.Write(GetWritePosition(i), writeL * volume, writeR * volume);
+		break;
+	}
+}
+
+// counts how long everything going into and coming out of the tape has
+// stayed below the silence threshold
+void CocoaDelayEngine::UpdateTail(int n)
+{
+	auto peak = 0.0;
+	for (int p = 0; p < numPairs; p++)
+	{
+		auto &pair = pairs[p];
+		for (int i = 0; i < n; i++)
+		{
+			peak = fmax(peak, fmax(fabs(pair.in[0][i]), fabs(pair.in[1][i])));
+			peak = fmax(peak, fmax(fabs(pair.out[0][i]), fabs(pair.out[1][i])));
+		}
+	}
+	quietSamples = peak < silenceThreshold ? quietSamples + n : 0;
+}
+
+// the tail is over once nothing that's been written to the tape since it went
+// quiet could still be read back, with a little extra for the filters and the
+// oversampler to settle
+bool CocoaDelayEngine::IsTailFinished()
+{
+	const double settleTime = .05;
+	return quietSamples >= GetRequiredTapeLength() + (size_t)(settleTime * sampleRate);
+}
+
+template<class T>
+bool CocoaDelayEngine::IsSilent(const T* const* inputs, int nFrames, bool monoInput)
+{
+	for (int c = 0; c < (monoInput ? 1 : numChannels); c++)
+		for (int i = 0; i < nFrames; i++)
+			if (fabs(inputs[c][i]) >= silenceThreshold) return false;
+	return true;
+}
+
+// while the engine is idle, the tape just has silence written to it and the
+// output is the dry signal. nothing else moves, apart from the duck follower
+// decaying the way it would with a silent input
+template<class T>
+void CocoaDelayEngine::ProcessIdle(const T* const* inputs, T* const* outputs, int nFrames, bool monoInput, bool monoOutput)
+{
+	for (int p = 0; p < numPairs; p++)
+	{
+		auto &pair = pairs[p];
+		for (int i = 0; i < nFrames; i++)
+		{
+			if (pair.mono)
+				pair.tape.Write(GetWritePosition(i), 0.0);
+			else
+				pair.tape.Write(GetWritePosition(i), 0.0, 0.0);
+		}
+	}
+	for (int offset = 0; offset < nFrames; offset += maxChunkLength)
+	{
+		auto n = nFrames - offset < maxChunkLength ? nFrames - offset : maxChunkLength;
+		dryVolume.Fill(chunk.dryVolume, n);
+
+		// read the inputs up front, the same as PrepareChunk, since
+		// an output can point to an input that's still to be read
+		ReadChunkInput(inputs, offset, n, monoInput);
+		for (int p = 0; p < numPairs; p++)
+		{
+			for (int lane = 0; lane < (pairs[p].mono ? 1 : 2); lane++)
+			{
+				auto c = pairs[p].channels[lane];
+				if (monoOutput && c != 0) continue;
+				auto in = pairs[p].in[lane];
+				for (int i = 0; i < n; i++)
+					outputs[c][offset + i] = (T)(in[i] * chunk.dryVolume[i]);
+			}
+		}
+	}
+	UpdateWritePosition(nFrames);
+	quietSamples += nFrames;
+	duckFollower *= pow(1.0 - parameters.duckReleaseSpeed * dt, nFrames);
+}
+
+// the state that decays towards zero when the input goes quiet. the tape flushes
+// itself as it's written, and the rest only holds values derived from these
+void CocoaDelayEngine::FlushDenormals()
+{
+	for (int p = 0; p < numPairs; p++)
+	{
+		pairs[p].lp.Flush();
+		pairs[p].hp.Flush();
+		pairs[p].driveFilter.Flush();
+	}
+	duckFollower = flushToZero(duckFollower);
+}
+
+template<class T>
+void CocoaDelayEngine::ProcessBlock(const T* const* inputs, T* const* outputs, int nFrames)
+{
+	if (pairs[0].tape.IsEmpty()) Reset(sampleRate);
+	GrowTape(nFrames);
+
+	auto monoInput = numChannels == 1 || (numChannels == 2 && inputs[1] == inputs[0]);
+	auto monoOutput = numChannels == 1 || (numChannels == 2 && outputs[1] == outputs[0]);
+
+	StartRamps(nFrames);
+	if (idle)
+	{
+		// the read positions stopped moving while the engine was idle, but there's
+		// nothing on the tape to hear, so they can jump straight to where they should be
+		idle = IsTailFinished() && IsSilent(inputs, nFrames, monoInput);
+		if (!idle) ResetReadPositions();
+	}
+	if (idle)
+		ProcessIdle(inputs, outputs, nFrames, monoInput, monoOutput);
+	else
+	{
+		for (int offset = 0; offset < nFrames; offset += maxChunkLength)
+		{
+			auto n = nFrames - offset < maxChunkLength ? nFrames - offset : maxChunkLength;
+			PrepareChunk(inputs, offset, n, monoInput);
+			auto independent = IsChunkIndependent(n);
+			for (int p = 0; p < numPairs; p++)
+			{
+				if (independent)
+					ProcessChunk(pairs[p], n);
+				else
+					ProcessChunkBySample(pairs[p], n);
+			}
+			UpdateWritePosition(n);
+			UpdateTail(n);
+			WriteChunkOutput(outputs, offset, n, monoOutput);
+		}
+		idle = IsTailFinished();
+	}
+	FinishRamps();
+	FlushDenormals();
+}
+
+void CocoaDelayEngine::Process(const float* const* inputs, float* const* outputs, int nFrames)
+{
+	ProcessBlock(inputs, outputs, nFrames);
+}
+
+void CocoaDelayEngine::Process(const double* const* inputs, double* const* outputs, int nFrames)
+{
+	ProcessBlock(inputs, outputs, nFrames);
+}
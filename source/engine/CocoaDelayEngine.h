@@ -0,0 +1,359 @@
+#pragma once
+
+#include "Filter.h"
+#include "Oversampler.h"
+#include "Ramp.h"
+#include "Random.h"
+#include "StatefulDrive.h"
+#include "Tape.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/*
+
+the delay's signal chain, shared by the iplug and juce front ends.
+it doesn't depend on either framework, so it can also be linked into
+command line tools. the front ends are responsible for translating their
+parameters into an EngineParameters struct and passing in the host tempo.
+
+*/
+
+enum class TempoSyncTimes
+{
+	tempoSyncOff,
+	whole,
+	dottedHalf,
+	half,
+	tripletHalf,
+	dottedQuarter,
+	quarter,
+	tripletQuarter,
+	dottedEighth,
+	eighth,
+	tripletEighth,
+	dottedSixteenth,
+	sixteenth,
+	tripletSixteenth,
+	dottedThirtysecond,
+	thirtysecond,
+	tripletThirtysecond,
+	dottedSixtyforth,
+	sixtyforth,
+	tripletSixtyforth,
+	numTempoSyncTimes
+};
+
+enum class PanModes
+{
+	stationary,
+	pingPong,
+	circular,
+	numPanModes
+};
+
+struct EngineParameters
+{
+	double delayTime = .2;
+	double lfoAmount = 0.0;
+	double lfoFrequency = 2.0;
+	double driftAmount = .001;
+	double driftSpeed = 1.0;
+	TempoSyncTimes tempoSyncTime = TempoSyncTimes::tempoSyncOff;
+	double feedback = .5;
+	double stereoOffset = 0.0;
+	PanModes panMode = PanModes::stationary;
+	double pan = 0.0; // in radians, -pi/2 to pi/2
+	double duckAmount = 0.0;
+	double duckAttackSpeed = 10.0;
+	double duckReleaseSpeed = 10.0;
+	FilterModes filterMode = FilterModes::onePole;
+	double lowPassCutoff = .75;
+	double highPassCutoff = .001;
+	double driveGain = .1;
+	double driveMix = 1.0;
+	double driveCutoff = 1.0;
+	int driveIterations = 1; // up to StatefulDrive::maxStages
+	DriveModes driveMode = DriveModes::standard;
+	int oversampling = 1; // for the drive. 1, 2, 4 or 8
+	double dryVolume = 1.0;
+	double wetVolume = .5;
+};
+
+// one channel, or two that the panning and stereo offset work between
+struct ChannelGroup
+{
+	int left = 0;
+	int right = -1; // -1 for a channel on its own
+};
+
+// settings that only take effect on the next Reset
+struct EngineConfig
+{
+	// enough for 7.1.4
+	static const int maxChannels = 12;
+
+	TapeLayout tapeLayout = TapeLayout::separate;
+	TapePrecision tapePrecision = TapePrecision::doublePrecision;
+
+	// how many samples apart the modulated delay time is evaluated.
+	// the read positions ramp linearly in between. 1 evaluates it every sample
+	int modulationInterval = 16;
+
+	// 1 to maxChannels
+	int numChannels = 2;
+
+	// which channels are processed together. the panning and stereo offset apply
+	// within each pair, and a channel on its own skips the panning. it's delayed
+	// like the left channel of a pair, stereo offset included, so a mono engine's
+	// echoes land at the same times as a stereo one's left channel. every channel
+	// has to be in exactly one group. with no groups, or groups that don't cover
+	// the channels, they're paired in order, 1 and 2, 3 and 4 and so on, and with
+	// an odd count the last channel is on its own
+	ChannelGroup channelGroups[maxChannels];
+	int numChannelGroups = 0;
+
+	// with reproducible set, every Reset reseeds the drift noise from seed, so the
+	// same input processed from a Reset always gives the same output. otherwise
+	// each engine picks its own seed and the noise carries on across resets.
+	// engines with the same seed drift identically, so the front ends give each
+	// instance a random seed when it's created and save it with the instance
+	bool reproducible = false;
+	uint64_t seed = 0;
+};
+
+class CocoaDelayEngine
+{
+public:
+	void SetConfig(const EngineConfig &c) { config = c; }
+	const EngineConfig& GetConfig() const { return config; }
+	void Reset(double sampleRate);
+	void SetParameters(const EngineParameters &p);
+	const EngineParameters& GetParameters() const { return parameters; }
+	// with ramp set, the beat length moves linearly from the last tempo
+	// to this one over the next block. otherwise it jumps straight to it.
+	// the tape is sized for the tempo at the last Reset, or for the longest
+	// it can be if no tempo had been set yet. if the host slows down far enough
+	// that a synced delay needs more tape, it's held at the longest the tape can
+	// manage until UpdateTape has made a longer one
+	void SetTempo(double bpm, bool ramp = true);
+
+	// makes a longer tape if the tempo needs one. it allocates, so it's meant to be
+	// called regularly from a thread other than the audio thread, like a timer on
+	// the ui thread. the new tape is swapped in at the start of the next block, with
+	// everything on the old one copied across. it's safe to call at any time
+	void UpdateTape();
+
+	// the furthest the front ends let the parameters that lengthen the delay go.
+	// the tape is sized in Reset for the longest delay any settings within these
+	// ranges can reach, so changing the parameters never reallocates it
+	static constexpr double maxDelayTime = 2.0;
+	static constexpr double maxLfoAmount = .5;
+	static constexpr double maxDriftAmount = .05;
+	static constexpr double maxStereoOffset = .5;
+
+	static const int maxChannels = EngineConfig::maxChannels;
+
+	// processes a block of audio, with one input and output per channel in the config.
+	// inputs and outputs may point to the same buffers. for a stereo engine, if both
+	// input channels point to the same buffer, the input is treated as mono, and if
+	// both output channels point to the same buffer, only the left output is written.
+	void Process(const float* const* inputs, float* const* outputs, int nFrames);
+	void Process(const double* const* inputs, double* const* outputs, int nFrames);
+
+	// true while the tail has died away and the input is silent. in that state
+	// the output is just the dry signal, and processing costs next to nothing
+	bool IsIdle() const { return idle; }
+
+	// how long the output can keep going after the input stops, in seconds.
+	// infinite if the feedback is at full strength. this only depends on the
+	// parameters and the tempo, so it's safe to call from any thread
+	static double GetTailLength(const EngineParameters &parameters, double tempo);
+
+private:
+	template<class T> void ProcessBlock(const T* const* inputs, T* const* outputs, int nFrames);
+	static double GetBaseDelayTime(const EngineParameters &parameters, double beatLength);
+	double GetDelayTime(int lookahead = 0);
+	static double GetMaxDelayTime(const EngineParameters &parameters, double tempo);
+	static double GetLongestDelayTime(double tempo);
+	size_t GetRequiredTapeLength();
+	size_t GetTapeLength(double tempo);
+	void GrowTape(int nFrames);
+	void ResetRamps();
+	void ResetState();
+	void StartRamps(int nFrames);
+	void FinishRamps();
+	void GetReadPositions(double & l, double & r, int lookahead = 0);
+	double CompensateLatency(double readPosition);
+	void ResetReadPositions();
+	void InitChannelGroups();
+	void InitBuffer();
+	void UpdateReadPositions();
+	int GetWritePosition(int i);
+	void UpdateWritePosition(int n);
+	void UpdateParameters();
+	void UpdateDucking(double input);
+	void UpdateLfo();
+	void UpdateDrift();
+	struct ChannelPair;
+	template<class T> void ReadChunkInput(const T* const* inputs, int offset, int n, bool monoInput);
+	template<class T> void PrepareChunk(const T* const* inputs, int offset, int n, bool monoInput);
+	bool IsChunkIndependent(int n);
+	void ProcessChunk(ChannelPair &pair, int n);
+	void ProcessChunkBySample(ChannelPair &pair, int n);
+	template<class T> void WriteChunkOutput(T* const* outputs, int offset, int n, bool monoOutput);
+	void ReadFromBuffer(ChannelPair &pair, int i);
+	void Drive(ChannelPair &pair, int i);
+	Double2 Drive(ChannelPair &pair, Double2 input, int i, double filterCoefficient);
+	void WriteToBuffer(ChannelPair &pair, int i);
+	void FlushDenormals();
+	void UpdateTail(int n);
+	bool IsTailFinished();
+	template<class T> bool IsSilent(const T* const* inputs, int nFrames, bool monoInput);
+	template<class T> void ProcessIdle(const T* const* inputs, T* const* outputs, int nFrames, bool monoInput, bool monoOutput);
+
+	// blocks are processed in chunks of up to this many samples
+	static const int maxChunkLength = 128;
+
+	// upper limit for the tape, in seconds, the same as the fixed length it used
+	// to have. slow host tempos combined with deep modulation can ask for more
+	// than this, in which case the delay is held at the longest the tape allows
+	static const int maxTapeLength = 10;
+
+	// how many frames of the old tape are copied onto a longer one each block,
+	// on top of the ones written that block, so no one block copies all of it
+	static const int tapeCopyLength = 16384;
+
+	// -140 dbfs. anything quieter than this counts as silence
+	static constexpr double silenceThreshold = 1e-7;
+
+	EngineConfig config;
+	EngineParameters parameters;
+	double sampleRate = 44100.0;
+	double dt = 1.0 / 44100.0;
+	double tempo = 120.0;
+	bool tempoKnown = false;
+
+	// delay. every pair's tape is the same length, so they share a write position
+	int numChannels = 2;
+	int numPairs = 1;
+	int writePosition = 0;
+	uint64_t framesWritten = 0;
+	double readPositionL = 0.0;
+	double readPositionR = 0.0;
+
+	// control rate modulation. the read positions chase targets that ramp
+	// towards the next control rate evaluation of the delay time
+	double targetReadPositionL = 0.0;
+	double targetReadPositionR = 0.0;
+	double nextReadPositionL = 0.0;
+	double nextReadPositionR = 0.0;
+	double targetStepL = 0.0;
+	double targetStepR = 0.0;
+	int modulationCounter = 0;
+	bool warmedUp = false;
+
+	// smoothed parameters. the rest are either smoothed elsewhere
+	// or only change how fast something else moves
+	Ramp feedback;
+	Ramp lowPassCutoff;
+	Ramp highPassCutoff;
+	Ramp driveGain;
+	Ramp driveMix;
+	Ramp driveCutoff;
+	Ramp duckAmount;
+	Ramp dryVolume;
+	Ramp wetVolume;
+	Ramp beatLengthRamp;
+
+	// fading parameters
+	PanModes currentPanMode = PanModes::stationary;
+	double parameterChangeVolume = 1.0;
+	double stationaryPanAmount = 0.0;
+	double circularPanAmount = 0.0;
+
+	// modulation
+	double duckFollower = 0.0;
+	double lfoPhase = 0.0;
+	double driftVelocity = 0.0;
+	double driftPhase = 0.0;
+	Random random{ Random::GetUniqueSeed() };
+
+	// silence detection
+	size_t quietSamples = 0;
+	bool idle = false;
+
+	// the audio path for a channel group, whose channels run side by side as the two
+	// lanes of a Double2. everything that doesn't depend on the audio is shared between pairs
+	struct ChannelPair
+	{
+		// the engine channel for each lane. the second lane of a mono pair stays silent
+		int channels[2] = { 0, -1 };
+		bool mono = false;
+		Tape tape;
+		MultiFilter<false> lp;
+		MultiFilter<true> hp;
+		StatefulDrive statefulDrive;
+		TwoPoleFilter<Double2> driveFilter;
+		Oversampler oversampler;
+
+		// the chunk being processed, for each channel
+		double in[2][maxChunkLength] = {};
+		double out[2][maxChunkLength] = {};
+	} pairs[maxChannels];
+
+	// hands a longer tape over from UpdateTape to the audio thread. the audio
+	// thread asks for a length, UpdateTape allocates the new tapes and marks them
+	// ready, and the audio thread swaps them in, leaving the old ones behind for
+	// UpdateTape to free. it's kept on the heap since the mutex can't be moved
+	struct TapeGrowth
+	{
+		enum class State
+		{
+			idle,
+			ready,
+			swapped
+		};
+
+		// keeps UpdateTape and Reset apart. the audio thread never takes it
+		std::mutex mutex;
+		std::atomic<State> state{ State::idle };
+		std::atomic<size_t> requestedLength{ 0 };
+
+		// only touched with the mutex held, or by the audio thread while ready
+		bool copying = false;
+		uint64_t copyPosition = 0;
+		size_t length = 0;
+		TapeLayout layout = TapeLayout::separate;
+		TapePrecision precision = TapePrecision::doublePrecision;
+		Tape tapes[maxChannels];
+	};
+	std::unique_ptr<TapeGrowth> tapeGrowth = std::make_unique<TapeGrowth>();
+
+	// per-sample values for the chunk being processed. the modulation doesn't
+	// depend on the audio, so it's worked out for the whole chunk up front
+	struct Chunk
+	{
+		double readPositionL[maxChunkLength];
+		double readPositionR[maxChunkLength];
+		PanModes panMode[maxChunkLength];
+		double parameterChangeVolume[maxChunkLength];
+		double stationaryPanCos[maxChunkLength];
+		double stationaryPanSin[maxChunkLength];
+		double circularPanCos[maxChunkLength];
+		double circularPanSin[maxChunkLength];
+		double duckFollower[maxChunkLength];
+		double feedback[maxChunkLength];
+		double lowPassCutoff[maxChunkLength];
+		double highPassCutoff[maxChunkLength];
+		// when a cutoff holds still, the filters only work out its coefficient once
+		bool lowPassCutoffMoving;
+		bool highPassCutoffMoving;
+		double driveGain[maxChunkLength];
+		double driveMix[maxChunkLength];
+		double driveCutoff[maxChunkLength];
+		double duckAmount[maxChunkLength];
+		double dryVolume[maxChunkLength];
+		double wetVolume[maxChunkLength];
+	} chunk;
+};
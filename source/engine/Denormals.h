@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Simd.h"
+
+/*
+
+turns on flush to zero and denormals are zero for as long as it's in scope,
+and puts the previous mode back afterwards. a feedback tail decays through
+the subnormal range on its way to silence, and arithmetic on subnormals can
+be around a hundred times slower, so the audio callbacks should hold one of
+these. the engine also flushes its decaying state explicitly, since there's
+no such mode to turn on everywhere.
+
+*/
+
+class ScopedFlushDenormals
+{
+public:
+#if defined(COCOA_DELAY_SSE2)
+	ScopedFlushDenormals() : previous(_mm_getcsr())
+	{
+		// bit 15 is flush to zero, bit 6 is denormals are zero
+		_mm_setcsr(previous | 0x8040);
+	}
+	~ScopedFlushDenormals() { _mm_setcsr(previous); }
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+	ScopedFlushDenormals()
+	{
+		// arm has one bit that covers both
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(previous));
+		unsigned long long fpcr = previous | (1ull << 24);
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+	}
+	~ScopedFlushDenormals() { __asm__ __volatile__("msr fpcr, %0" : : "r"(previous)); }
+#else
+	ScopedFlushDenormals() {}
+#endif
+	ScopedFlushDenormals(const ScopedFlushDenormals&) = delete;
+	ScopedFlushDenormals& operator=(const ScopedFlushDenormals&) = delete;
+
+private:
+#if defined(COCOA_DELAY_SSE2)
+	unsigned int previous;
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+	unsigned long long previous;
+#endif
+};
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "Simd.h"
+#include "Util.h"
+#include <cmath>
+#include <tuple>
+
+enum class FilterModes
+{
+	onePole,
+	twoPole,
+	fourPole,
+	stateVariable,
+	numFilterModes,
+	noFilter
+};
+
+// the filters are templated on the sample type, so the same code can process
+// a single channel (double) or both channels at once (Double2).
+// coefficients are worked out in double precision.
+
+// gives each filter a per-sample Process and two block versions: one with a
+// cutoff per sample, and one with a fixed cutoff, where the coefficient is only
+// worked out once. filters provide GetCoefficient(dt, cutoff) and Tick(input, k, highPass).
+template<class Filter, class T>
+class BlockFilter
+{
+public:
+	T Process(double dt, T input, double cutoff, bool highPass = false)
+	{
+		return Self().Tick(input, Self().GetCoefficient(dt, cutoff), highPass);
+	}
+
+	void Process(double dt, const T* in, T* out, int n, const double* cutoff, bool highPass = false)
+	{
+		for (int i = 0; i < n; i++)
+			out[i] = Self().Tick(in[i], Self().GetCoefficient(dt, cutoff[i]), highPass);
+	}
+
+	void Process(double dt, const T* in, T* out, int n, double cutoff, bool highPass = false)
+	{
+		auto k = Self().GetCoefficient(dt, cutoff);
+		for (int i = 0; i < n; i++)
+			out[i] = Self().Tick(in[i], k, highPass);
+	}
+
+private:
+	Filter& Self() { return static_cast<Filter&>(*this); }
+};
+
+inline double GetCutoffCoefficient(double dt, double cutoff)
+{
+	cutoff *= 44100 * dt;
+	return cutoff > 1.0 ? 1.0 : cutoff;
+}
+
+template<class T = double>
+class OnePoleFilter : public BlockFilter<OnePoleFilter<T>, T>
+{
+public:
+	void Reset()
+	{
+		a = 0.0;
+	}
+	void Flush()
+	{
+		a = flushToZero(a);
+	}
+	static double GetCoefficient(double dt, double cutoff)
+	{
+		return GetCutoffCoefficient(dt, cutoff);
+	}
+	T Tick(T input, T k, bool highPass)
+	{
+		a += (input - a) * k;
+		return highPass ? input - a : a;
+	}
+
+private:
+	T a = 0.0;
+};
+
+template<class T = double>
+class TwoPoleFilter : public BlockFilter<TwoPoleFilter<T>, T>
+{
+public:
+	void Reset()
+	{
+		a = 0.0;
+		b = 0.0;
+	}
+	void Flush()
+	{
+		a = flushToZero(a);
+		b = flushToZero(b);
+	}
+	static double GetCoefficient(double dt, double cutoff)
+	{
+		return GetCutoffCoefficient(dt, cutoff);
+	}
+	T Tick(T input, T k, bool highPass)
+	{
+		a += (input - a) * k;
+		b += (a - b) * k;
+		return highPass ? input - b : b;
+	}
+
+private:
+	T a = 0.0;
+	T b = 0.0;
+};
+
+template<class T = double>
+class FourPoleFilter : public BlockFilter<FourPoleFilter<T>, T>
+{
+public:
+	void Reset()
+	{
+		a = 0.0;
+		b = 0.0;
+		c = 0.0;
+		d = 0.0;
+	}
+	void Flush()
+	{
+		a = flushToZero(a);
+		b = flushToZero(b);
+		c = flushToZero(c);
+		d = flushToZero(d);
+	}
+	static double GetCoefficient(double dt, double cutoff)
+	{
+		return GetCutoffCoefficient(dt, cutoff);
+	}
+	T Tick(T input, T k, bool highPass)
+	{
+		a += (input - a) * k;
+		b += (a - b) * k;
+		c += (b - c) * k;
+		d += (c - d) * k;
+		return highPass ? input - d : d;
+	}
+
+private:
+	T a = 0.0;
+	T b = 0.0;
+	T c = 0.0;
+	T d = 0.0;
+};
+
+template<class T = double>
+class StateVariableFilter : public BlockFilter<StateVariableFilter<T>, T>
+{
+public:
+	void Reset()
+	{
+		band = 0.0;
+		low = 0.0;
+	}
+	void Flush()
+	{
+		band = flushToZero(band);
+		low = flushToZero(low);
+	}
+	// the cutoff only moves while its parameter is changing, so the last
+	// coefficient is kept around to skip the sin the rest of the time
+	double GetCoefficient(double dt, double cutoff)
+	{
+		if (cutoff == lastCutoff && dt == lastDt) return lastK;
+		lastCutoff = cutoff;
+		lastDt = dt;
+		auto f = 2 * sin(Util::pi * (cutoff * 8000.0) * dt);
+		lastK = f > 1.0 ? 1.0 : f < 0.0 ? 0.0 : f;
+		return lastK;
+	}
+	T Tick(T input, T k, bool highPass)
+	{
+		input *= .9;
+		auto high = input - (low + band);
+		band += k * high;
+		low += k * band;
+		return highPass ? high : low;
+	}
+
+private:
+	T band = 0.0;
+	T low = 0.0;
+	double lastCutoff = -1.0;
+	double lastDt = 0.0;
+	double lastK = 0.0;
+};
+
+// runs both channels through one filter with two lanes of state
+template<template<class> class Filter>
+class DualFilter
+{
+public:
+	void Reset()
+	{
+		filter.Reset();
+	}
+	void Flush()
+	{
+		filter.Flush();
+	}
+	Double2 Process(double dt, Double2 input, double cutoff, bool highPass = false)
+	{
+		return filter.Process(dt, input, cutoff, highPass);
+	}
+	void Process(double dt, double inL, double inR, double cutoff, double &outL, double &outR, bool highPass = false)
+	{
+		auto out = Process(dt, Double2(inL, inR), cutoff, highPass);
+		outL = out.Left();
+		outR = out.Right();
+	}
+
+	// block versions. the inputs and outputs may be the same buffers
+	void Process(double dt, const double* inL, const double* inR, double* outL, double* outR, int n, const double* cutoff, bool highPass = false)
+	{
+		for (int i = 0; i < n; i++)
+			Tick(i, inL, inR, outL, outR, filter.GetCoefficient(dt, cutoff[i]), highPass);
+	}
+	void Process(double dt, const double* inL, const double* inR, double* outL, double* outR, int n, double cutoff, bool highPass = false)
+	{
+		auto k = filter.GetCoefficient(dt, cutoff);
+		for (int i = 0; i < n; i++)
+			Tick(i, inL, inR, outL, outR, k, highPass);
+	}
+
+private:
+	void Tick(int i, const double* inL, const double* inR, double* outL, double* outR, double k, bool highPass)
+	{
+		auto out = filter.Tick(Double2(inL[i], inR[i]), k, highPass);
+		outL[i] = out.Left();
+		outR[i] = out.Right();
+	}
+
+	Filter<Double2> filter;
+};
+
+// all four filter modes are stored inline, and the mode is dispatched with a switch
+// onto code specialized for that mode, so the whole filter bank can be inlined.
+// highPass is a template parameter for the same reason.
+template<bool highPass>
+class MultiFilter
+{
+public:
+	void SetMode(FilterModes m)
+	{
+		if (currentMode != m)
+		{
+			previousMode = currentMode;
+			currentMode = m;
+			crossfading = true;
+			currentModeMix = 0.0;
+		}
+	}
+
+	void Process(double dt, double &l, double &r, double cutoff)
+	{
+		Double2 in(l, r);
+		Double2 out;
+		switch (crossfading)
+		{
+		case true:
+		{
+			currentModeMix += 100.0 * dt;
+			if (currentModeMix >= 1.0)
+			{
+				currentModeMix = 1.0;
+				crossfading = false;
+				Reset(previousMode);
+			}
+
+			out = Process(previousMode, dt, in, cutoff) * (1.0 - currentModeMix);
+			out += Process(currentMode, dt, in, cutoff) * currentModeMix;
+			break;
+		}
+		case false:
+			out = Process(currentMode, dt, in, cutoff);
+			break;
+		}
+		l = out.Left();
+		r = out.Right();
+	}
+
+	// clears all of the filters and finishes any crossfade
+	void Reset()
+	{
+		std::get<(int)FilterModes::onePole>(filters).Reset();
+		std::get<(int)FilterModes::twoPole>(filters).Reset();
+		std::get<(int)FilterModes::fourPole>(filters).Reset();
+		std::get<(int)FilterModes::stateVariable>(filters).Reset();
+		previousMode = FilterModes::noFilter;
+		crossfading = false;
+		currentModeMix = 1.0;
+	}
+
+	// snaps decaying filter states to zero before they turn subnormal.
+	// cheap enough to call once a block
+	void Flush()
+	{
+		std::get<(int)FilterModes::onePole>(filters).Flush();
+		std::get<(int)FilterModes::twoPole>(filters).Flush();
+		std::get<(int)FilterModes::fourPole>(filters).Flush();
+		std::get<(int)FilterModes::stateVariable>(filters).Flush();
+	}
+
+	// block versions, processing l and r in place. while the mode is crossfading
+	// this falls back to processing one sample at a time
+	void Process(double dt, double* l, double* r, int n, const double* cutoff)
+	{
+		if (crossfading)
+		{
+			for (int i = 0; i < n; i++) Process(dt, l[i], r[i], cutoff[i]);
+			return;
+		}
+		switch (currentMode)
+		{
+		case FilterModes::onePole: Process<FilterModes::onePole>(dt, l, r, n, cutoff); break;
+		case FilterModes::twoPole: Process<FilterModes::twoPole>(dt, l, r, n, cutoff); break;
+		case FilterModes::fourPole: Process<FilterModes::fourPole>(dt, l, r, n, cutoff); break;
+		case FilterModes::stateVariable: Process<FilterModes::stateVariable>(dt, l, r, n, cutoff); break;
+		default: break;
+		}
+	}
+
+	void Process(double dt, double* l, double* r, int n, double cutoff)
+	{
+		if (crossfading)
+		{
+			for (int i = 0; i < n; i++) Process(dt, l[i], r[i], cutoff);
+			return;
+		}
+		switch (currentMode)
+		{
+		case FilterModes::onePole: Process<FilterModes::onePole>(dt, l, r, n, cutoff); break;
+		case FilterModes::twoPole: Process<FilterModes::twoPole>(dt, l, r, n, cutoff); break;
+		case FilterModes::fourPole: Process<FilterModes::fourPole>(dt, l, r, n, cutoff); break;
+		case FilterModes::stateVariable: Process<FilterModes::stateVariable>(dt, l, r, n, cutoff); break;
+		default: break;
+		}
+	}
+
+private:
+	template<FilterModes mode, class Cutoff>
+	void Process(double dt, double* l, double* r, int n, Cutoff cutoff)
+	{
+		std::get<(int)mode>(filters).Process(dt, l, r, l, r, n, cutoff, highPass);
+	}
+
+	template<FilterModes mode>
+	Double2 Process(double dt, Double2 in, double cutoff)
+	{
+		return std::get<(int)mode>(filters).Process(dt, in, cutoff, highPass);
+	}
+
+	Double2 Process(FilterModes mode, double dt, Double2 in, double cutoff)
+	{
+		switch (mode)
+		{
+		case FilterModes::onePole: return Process<FilterModes::onePole>(dt, in, cutoff);
+		case FilterModes::twoPole: return Process<FilterModes::twoPole>(dt, in, cutoff);
+		case FilterModes::fourPole: return Process<FilterModes::fourPole>(dt, in, cutoff);
+		case FilterModes::stateVariable: return Process<FilterModes::stateVariable>(dt, in, cutoff);
+		default: return in;
+		}
+	}
+
+	void Reset(FilterModes mode)
+	{
+		switch (mode)
+		{
+		case FilterModes::onePole: std::get<(int)FilterModes::onePole>(filters).Reset(); break;
+		case FilterModes::twoPole: std::get<(int)FilterModes::twoPole>(filters).Reset(); break;
+		case FilterModes::fourPole: std::get<(int)FilterModes::fourPole>(filters).Reset(); break;
+		case FilterModes::stateVariable: std::get<(int)FilterModes::stateVariable>(filters).Reset(); break;
+		default: break;
+		}
+	}
+
+	std::tuple<
+		DualFilter<OnePoleFilter>,
+		DualFilter<TwoPoleFilter>,
+		DualFilter<FourPoleFilter>,
+		DualFilter<StateVariableFilter>
+	> filters;
+	FilterModes currentMode = FilterModes::onePole;
+	FilterModes previousMode = FilterModes::noFilter;
+	bool crossfading = false;
+	double currentModeMix = 1.0;
+};
@@ -0,0 +1,138 @@
+#include "Oversampler.h"
+#include <cmath>
+
+namespace
+{
+	// modified bessel function of the first kind, for the kaiser window
+	double BesselI0(double x)
+	{
+		auto sum = 1.0;
+		auto term = 1.0;
+		for (int k = 1; k < 50; k++)
+		{
+			term *= (x * .5 / k) * (x * .5 / k);
+			sum += term;
+			if (term < sum * 1e-17) break;
+		}
+		return sum;
+	}
+}
+
+// a kaiser windowed sinc. a beta of 8 puts the stopband at around -80db
+void HalfBandFilter::Init(int t)
+{
+	const double beta = 8.0;
+	taps = t < 1 ? 1 : t > maxTaps ? maxTaps : t;
+	auto center = GetCenter();
+	auto sum = 0.0;
+	for (int i = 0; i < 2 * taps; i++)
+	{
+		// h[2i] is an odd number of samples away from the center
+		auto offset = 2 * i - center;
+		auto x = offset * .5 * 3.141592653589793;
+		auto window = (double)offset / (center + 1);
+		coefficients[i] = .5 * sin(x) / x * BesselI0(beta * sqrt(1.0 - window * window)) / BesselI0(beta);
+		sum += coefficients[i];
+	}
+
+	// make the gain at dc exactly 1. the center tap is .5, so the rest add up to .5
+	for (int i = 0; i < 2 * taps; i++)
+		coefficients[i] *= .5 / sum;
+
+	Reset();
+}
+
+void HalfBandFilter::Reset()
+{
+	for (auto &h : history) h = 0.0;
+	for (auto &h : oddHistory) h = 0.0;
+	historyPosition = 0;
+	oddHistoryPosition = 0;
+}
+
+void HalfBandFilter::Push(Double2* buffer, int length, int &position, Double2 value)
+{
+	position = position > 0 ? position - 1 : length - 1;
+	buffer[position] = value;
+	buffer[position + length] = value;
+}
+
+// the upsampled signal is the input with zeros in between, doubled to keep the
+// same level. the even outputs only see the even taps, and the odd outputs only
+// see the center tap, which makes them a delayed copy of the input
+void HalfBandFilter::Upsample(Double2 input, Double2 &first, Double2 &second)
+{
+	Push(history, 2 * taps, historyPosition, input);
+	auto x = history + historyPosition;
+	Double2 sum = 0.0;
+	for (int i = 0; i < 2 * taps; i++)
+		sum += x[i] * coefficients[i];
+	first = sum * 2.0;
+	second = x[taps - 1];
+}
+
+// only every other output is kept, so only those are worked out.
+// the odd inputs only meet the center tap
+Double2 HalfBandFilter::Downsample(Double2 first, Double2 second)
+{
+	Push(history, 2 * taps, historyPosition, first);
+	Push(oddHistory, taps + 1, oddHistoryPosition, second);
+	auto x = history + historyPosition;
+	Double2 sum = 0.0;
+	for (int i = 0; i < 2 * taps; i++)
+		sum += x[i] * coefficients[i];
+	return sum + oddHistory[oddHistoryPosition + taps] * .5;
+}
+
+// the first stage does the most work, since it has to keep everything up to near
+// the original nyquist frequency. later stages only have to get rid of images
+// that are much further away, so they can use far fewer taps
+void Oversampler::Init(int f)
+{
+	const int taps[maxStages] = { 16, 6, 4 };
+	numStages = f >= 8 ? 3 : f >= 4 ? 2 : f >= 2 ? 1 : 0;
+	factor = 1 << numStages;
+	latency = 0.0;
+	for (int i = 0; i < numStages; i++)
+	{
+		upsamplers[i].Init(taps[i]);
+		downsamplers[i].Init(taps[i]);
+
+		// each stage delays by its center tap on the way up and again on the way down,
+		// in samples at 2^(i + 1) times the original rate
+		latency += 2.0 * upsamplers[i].GetCenter() / (2 << i);
+	}
+}
+
+void Oversampler::Reset()
+{
+	for (int i = 0; i < numStages; i++)
+	{
+		upsamplers[i].Reset();
+		downsamplers[i].Reset();
+	}
+}
+
+void Oversampler::Upsample(Double2 input, Double2* output)
+{
+	output[0] = input;
+	Double2 scratch[maxFactor];
+	for (int stage = 0; stage < numStages; stage++)
+	{
+		auto n = 1 << stage;
+		for (int i = 0; i < n; i++) scratch[i] = output[i];
+		for (int i = 0; i < n; i++)
+			upsamplers[stage].Upsample(scratch[i], output[2 * i], output[2 * i + 1]);
+	}
+}
+
+Double2 Oversampler::Downsample(Double2* input)
+{
+	for (int stage = numStages - 1; stage >= 0; stage--)
+	{
+		auto n = 1 << stage;
+		for (int i = 0; i < n; i++)
+			input[i] = downsamplers[stage].Downsample(input[2 * i], input[2 * i + 1]);
+	}
+	return input[0];
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Simd.h"
+
+/*
+
+oversampling for the drive, built from a chain of 2x stages. each stage is a
+linear phase half-band fir. every other tap of a half-band filter is zero, and
+so is every other sample after upsampling, so the filters are run in polyphase
+form, which skips both.
+
+*/
+
+class HalfBandFilter
+{
+public:
+	// taps on each side of the center that aren't zero
+	static const int maxTaps = 16;
+
+	void Init(int taps);
+	void Reset();
+
+	// takes one sample at the lower rate and gives two at the higher rate
+	void Upsample(Double2 input, Double2 &first, Double2 &second);
+
+	// takes two samples at the higher rate and gives one at the lower rate
+	Double2 Downsample(Double2 first, Double2 second);
+
+	// how far the center tap is from the first one, in samples at the higher rate
+	int GetCenter() const { return 2 * taps - 1; }
+
+private:
+	static void Push(Double2* history, int length, int &position, Double2 value);
+
+	int taps = 1;
+
+	// the taps that aren't zero or the center, h[0], h[2], h[4]...
+	double coefficients[2 * maxTaps] = {};
+
+	// the most recent inputs, newest first from position. each one is written
+	// twice, length samples apart, so they can be read without wrapping
+	Double2 history[4 * maxTaps];
+	int historyPosition = 0;
+	Double2 oddHistory[2 * (maxTaps + 1)];
+	int oddHistoryPosition = 0;
+};
+
+class Oversampler
+{
+public:
+	static const int maxFactor = 8;
+
+	// the factor can be 1, 2, 4 or 8. this doesn't allocate, so it's safe to
+	// call from the audio thread
+	void Init(int factor);
+	void Reset();
+	int GetFactor() const { return factor; }
+
+	// the delay added by going up and back down, in samples at the original rate
+	double GetLatency() const { return latency; }
+
+	// turns one sample into GetFactor() samples
+	void Upsample(Double2 input, Double2* output);
+
+	// turns GetFactor() samples back into one. input is used as scratch space
+	Double2 Downsample(Double2* input);
+
+private:
+	static const int maxStages = 3;
+
+	int factor = 1;
+	int numStages = 0;
+	double latency = 0.0;
+	HalfBandFilter upsamplers[maxStages];
+	HalfBandFilter downsamplers[maxStages];
+};
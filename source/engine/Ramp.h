@@ -0,0 +1,55 @@
+#pragma once
+
+// moves linearly from the value it had at the end of the last block
+// to the latest parameter value over the course of the next block
+class Ramp
+{
+public:
+	void Reset(double v)
+	{
+		value = target = v;
+		step = 0.0;
+	}
+
+	void Start(double t, int nFrames)
+	{
+		target = t;
+		step = nFrames > 0 ? (target - value) / nFrames : 0.0;
+	}
+
+	// the value lookahead samples after the current one, following the current step
+	double Get(int lookahead = 0) const
+	{
+		return value + step * lookahead;
+	}
+
+	double Next()
+	{
+		value += step;
+		return value;
+	}
+
+	// false while the value is holding still for the rest of the block
+	bool IsMoving() const
+	{
+		return step != 0.0;
+	}
+
+	// fills out with the next n values
+	void Fill(double* out, int n)
+	{
+		for (int i = 0; i < n; i++) out[i] = Next();
+	}
+
+	// snaps to the target to avoid accumulating rounding error across blocks
+	void Finish()
+	{
+		value = target;
+		step = 0.0;
+	}
+
+private:
+	double value = 0.0;
+	double target = 0.0;
+	double step = 0.0;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+
+/*
+
+xoshiro256** (https://prng.di.unimi.it). each engine owns one, so instances
+running on different threads don't share any state, and the sequence only
+depends on the seed it was given.
+
+*/
+
+class Random
+{
+public:
+	explicit Random(uint64_t seed = 0) { Seed(seed); }
+
+	// spreads the seed across the state with splitmix64, as the authors recommend,
+	// so nearby seeds still give unrelated sequences
+	void Seed(uint64_t seed)
+	{
+		for (auto &word : s)
+		{
+			seed += 0x9e3779b97f4a7c15;
+			auto z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			word = z ^ (z >> 31);
+		}
+	}
+
+	uint64_t Next()
+	{
+		auto result = Rotate(s[1] * 5, 7) * 9;
+		auto t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = Rotate(s[3], 45);
+		return result;
+	}
+
+	// uniform between -1 and 1, from the top 53 bits
+	double Bipolar()
+	{
+		return (Next() >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+	}
+
+	// a different seed every time it's called, for generators that
+	// don't need to be reproducible
+	static uint64_t GetUniqueSeed()
+	{
+		static std::atomic<uint64_t> counter{ 0 };
+		return counter.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// a seed from the system's entropy source, so it differs between processes
+	// and sessions too. slow, so it's for picking a seed once, not per engine
+	static uint64_t GetRandomSeed()
+	{
+		std::random_device device;
+		return ((uint64_t)device() << 32) ^ device();
+	}
+
+private:
+	static uint64_t Rotate(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	uint64_t s[4];
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COCOA_DELAY_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+
+// decaying state is snapped to zero once it gets this small. it's far below
+// anything audible, and still clear of where single precision goes subnormal
+const double flushThreshold = 1e-30;
+
+inline double flushToZero(double a) { return fabs(a) < flushThreshold ? 0.0 : a; }
+
+/*
+
+a pair of doubles, used to run the left and right channels through the same
+arithmetic in one instruction stream. it uses a single sse2 register where
+that's available, and falls back to two plain doubles elsewhere.
+
+*/
+
+#ifdef COCOA_DELAY_SSE2
+
+class Double2
+{
+public:
+	Double2() : v(_mm_setzero_pd()) {}
+	Double2(double x) : v(_mm_set1_pd(x)) {}
+	Double2(double left, double right) : v(_mm_set_pd(right, left)) {}
+	Double2(__m128d x) : v(x) {}
+
+	double Left() const { return _mm_cvtsd_f64(v); }
+	double Right() const { return _mm_cvtsd_f64(_mm_unpackhi_pd(v, v)); }
+
+	friend Double2 operator+(Double2 a, Double2 b) { return _mm_add_pd(a.v, b.v); }
+	friend Double2 operator-(Double2 a, Double2 b) { return _mm_sub_pd(a.v, b.v); }
+	friend Double2 operator*(Double2 a, Double2 b) { return _mm_mul_pd(a.v, b.v); }
+	friend Double2 operator/(Double2 a, Double2 b) { return _mm_div_pd(a.v, b.v); }
+	friend Double2 min(Double2 a, Double2 b) { return _mm_min_pd(a.v, b.v); }
+	friend Double2 max(Double2 a, Double2 b) { return _mm_max_pd(a.v, b.v); }
+	friend Double2 abs(Double2 a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+
+
+	// sine of both lanes, within about 1e-9 of std::sin. the input is brought into
+	// [-pi/2, pi/2] by taking away the nearest multiple of pi, which flips the sign
+	// if the multiple is odd. the rest goes through the taylor series up to x^13,
+	// grouped so the multiplies can overlap. the reduction loses precision as the
+	// multiple grows (about 1e-8 by 1e8) and breaks down completely once it no
+	// longer fits in an int, so anything over maxInput goes through std::sin instead
+	friend Double2 fastSin(Double2 a)
+	{
+		const double maxInput = 1e6;
+		if (_mm_movemask_pd(_mm_cmpgt_pd(abs(a).v, _mm_set1_pd(maxInput))))
+			return Double2(sin(a.Left()), sin(a.Right()));
+
+		const double piHigh = 3.141592653589793;
+		const double piLow = 1.2246467991473532e-16; // what piHigh is missing
+		auto k = _mm_cvtpd_epi32(_mm_mul_pd(a.v, _mm_set1_pd(1.0 / piHigh)));
+		auto kd = _mm_cvtepi32_pd(k);
+		Double2 x = _mm_sub_pd(_mm_sub_pd(a.v, _mm_mul_pd(kd, _mm_set1_pd(piHigh))), _mm_mul_pd(kd, _mm_set1_pd(piLow)));
+		auto sign = _mm_slli_epi64(_mm_unpacklo_epi32(k, k), 63);
+
+		auto x2 = x * x;
+		auto x4 = x2 * x2;
+		auto x8 = x4 * x4;
+		auto y = (Double2(1.0) - x2 * (1.0 / 6.0))
+			+ x4 * (Double2(1.0 / 120.0) - x2 * (1.0 / 5040.0))
+			+ x8 * ((Double2(1.0 / 362880.0) - x2 * (1.0 / 39916800.0)) + x4 * (1.0 / 6227020800.0));
+		return _mm_xor_pd((x * y).v, _mm_castsi128_pd(sign));
+	}
+
+	// 1 / a, or 0 wherever a is 0
+	friend Double2 inverseOrZero(Double2 a)
+	{
+		return _mm_and_pd(_mm_div_pd(_mm_set1_pd(1.0), a.v), _mm_cmpneq_pd(a.v, _mm_setzero_pd()));
+	}
+
+	// a, or 0 wherever it's under flushThreshold
+	friend Double2 flushToZero(Double2 a)
+	{
+		return _mm_and_pd(a.v, _mm_cmpge_pd(abs(a).v, _mm_set1_pd(flushThreshold)));
+	}
+
+private:
+	__m128d v;
+};
+
+#else
+
+class Double2
+{
+public:
+	Double2() : l(0.0), r(0.0) {}
+	Double2(double x) : l(x), r(x) {}
+	Double2(double left, double right) : l(left), r(right) {}
+
+	double Left() const { return l; }
+	double Right() const { return r; }
+
+	friend Double2 operator+(Double2 a, Double2 b) { return Double2(a.l + b.l, a.r + b.r); }
+	friend Double2 operator-(Double2 a, Double2 b) { return Double2(a.l - b.l, a.r - b.r); }
+	friend Double2 operator*(Double2 a, Double2 b) { return Double2(a.l * b.l, a.r * b.r); }
+	friend Double2 operator/(Double2 a, Double2 b) { return Double2(a.l / b.l, a.r / b.r); }
+	friend Double2 min(Double2 a, Double2 b) { return Double2(a.l < b.l ? a.l : b.l, a.r < b.r ? a.r : b.r); }
+	friend Double2 max(Double2 a, Double2 b) { return Double2(a.l > b.l ? a.l : b.l, a.r > b.r ? a.r : b.r); }
+	friend Double2 abs(Double2 a) { return Double2(fabs(a.l), fabs(a.r)); }
+	friend Double2 fastSin(Double2 a) { return Double2(sin(a.l), sin(a.r)); }
+	friend Double2 inverseOrZero(Double2 a) { return Double2(a.l == 0.0 ? 0.0 : 1.0 / a.l, a.r == 0.0 ? 0.0 : 1.0 / a.r); }
+	friend Double2 flushToZero(Double2 a) { return Double2(fabs(a.l) < flushThreshold ? 0.0 : a.l, fabs(a.r) < flushThreshold ? 0.0 : a.r); }
+
+private:
+	double l;
+	double r;
+};
+
+#endif
+
+inline Double2 &operator+=(Double2 &a, Double2 b) { return a = a + b; }
+inline Double2 &operator-=(Double2 &a, Double2 b) { return a = a - b; }
+inline Double2 &operator*=(Double2 &a, Double2 b) { return a = a * b; }
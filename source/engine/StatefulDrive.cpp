@@ -0,0 +1,153 @@
+#include "StatefulDrive.h"
+#include "Util.h"
+#include <cmath>
+
+/*
+
+this is a combo of two airwindows plugins. it uses the behavior of PurestDrive:
+https://github.com/airwindows/airwindows/blob/master/plugins/WinVST/PurestDrive/PurestDriveProc.cpp
+
+but with the saturation algorithm of Spiral:
+https://github.com/airwindows/airwindows/blob/master/plugins/WinVST/Spiral/SpiralProc.cpp
+
+*/
+
+/*
+
+the antialiased mode replaces the saturation f(x) = sin(x^2) / x with the average
+of f between the last input and the current one, (F(x1) - F(x0)) / (x1 - x0).
+that's much smoother than sampling f directly, so it aliases a lot less.
+the antiderivative is F(x) = Si(x^2) / 2, where Si is the sine integral.
+
+*/
+
+namespace
+{
+	// Si(u), the integral of sin(t) / t from 0 to u. it's tabulated once along
+	// with its slope, sin(u) / u, and read back with cubic hermite interpolation.
+	// past the end of the table the asymptotic expansion is accurate to about 1e-12
+	class SineIntegral
+	{
+	public:
+		SineIntegral()
+		{
+			// 5 point gauss-legendre quadrature over each step
+			const double nodes[] = { 0.0, -.5384693101056831, .5384693101056831, -.9061798459386640, .9061798459386640 };
+			const double weights[] = { .5688888888888889, .4786286704993665, .4786286704993665, .2369268850561891, .2369268850561891 };
+			values[0] = 0.0;
+			slopes[0] = 1.0;
+			for (int i = 1; i < length; i++)
+			{
+				auto center = (i - .5) * step;
+				auto integral = 0.0;
+				for (int j = 0; j < 5; j++)
+				{
+					auto t = center + nodes[j] * step * .5;
+					integral += weights[j] * sin(t) / t;
+				}
+				values[i] = values[i - 1] + integral * step * .5;
+				slopes[i] = sin(i * step) / (i * step);
+			}
+		}
+
+		double operator()(double u) const
+		{
+			if (u >= end)
+			{
+				auto u2 = 1.0 / (u * u);
+				auto f = (1.0 - u2 * (2.0 - u2 * 24.0)) / u;
+				auto g = (1.0 - u2 * (6.0 - u2 * 120.0)) * u2;
+				return Util::pi * .5 - f * cos(u) - g * sin(u);
+			}
+			auto position = u * (1.0 / step);
+			auto i = (int)position;
+			auto t = position - i;
+			auto t2 = t * t;
+			auto t3 = t2 * t;
+			return values[i] * (2 * t3 - 3 * t2 + 1) + values[i + 1] * (3 * t2 - 2 * t3)
+				+ (slopes[i] * (t3 - 2 * t2 + t) + slopes[i + 1] * (t3 - t2)) * step;
+		}
+
+	private:
+		static constexpr double step = 1.0 / 32;
+		static constexpr double end = 128.0;
+		static const int length = 4097; // end / step + 1
+
+		double values[length];
+		double slopes[length];
+	};
+
+	const SineIntegral sineIntegral;
+}
+
+Double2 StatefulDrive::Process(Double2 input, double amount, int stage)
+{
+	auto &state = stages[stage];
+
+	// the division doesn't depend on the sine, so they can run side by side
+	auto driven = fastSin(input * input) * inverseOrZero(input);
+	auto sum = previous + driven;
+	auto mix = abs(sum) * (.5 * amount);
+	previous = driven;
+	state.input = input;
+	state.sum = sum;
+	state.antiderivativeCurrent = false;
+	return input * (1.0 - mix) + driven * mix;
+}
+
+double StatefulDrive::Saturate(double input, double lastInput, double &lastAntiderivative)
+{
+	auto antiderivative = sineIntegral(input * input) * .5;
+	auto difference = input - lastInput;
+	double driven;
+	if (fabs(difference) > 1e-3)
+		driven = (antiderivative - lastAntiderivative) / difference;
+	else
+	{
+		// the two inputs are too close together to divide by the difference,
+		// but close enough that f halfway between them is a good estimate
+		auto middle = (input + lastInput) * .5;
+		driven = middle == 0.0 ? 0.0 : sin(middle * middle) / middle;
+	}
+	lastAntiderivative = antiderivative;
+	return driven;
+}
+
+// the average of abs(x) between the last input and this one. the antiderivative is x * abs(x) / 2
+double StatefulDrive::AverageAbs(double input, double lastInput)
+{
+	auto difference = input - lastInput;
+	return fabs(difference) > 1e-6
+		? (input * fabs(input) - lastInput * fabs(lastInput)) * .5 / difference
+		: fabs(input + lastInput) * .5;
+}
+
+Double2 StatefulDrive::ProcessAntialiased(Double2 input, double amount, int stage)
+{
+	auto &state = stages[stage];
+	auto lastInput = state.input;
+	if (!state.antiderivativeCurrent)
+	{
+		state.antiderivative[0] = sineIntegral(lastInput.Left() * lastInput.Left()) * .5;
+		state.antiderivative[1] = sineIntegral(lastInput.Right() * lastInput.Right()) * .5;
+		state.antiderivativeCurrent = true;
+	}
+	auto driven = Double2(
+		Saturate(input.Left(), lastInput.Left(), state.antiderivative[0]),
+		Saturate(input.Right(), lastInput.Right(), state.antiderivative[1]));
+
+	// the abs in the mix amount has a sharp corner, which aliases
+	// just as much as the saturation, so it gets the same treatment
+	auto sum = previous + driven;
+	previous = driven;
+	auto mix = Double2(AverageAbs(sum.Left(), state.sum.Left()), AverageAbs(sum.Right(), state.sum.Right())) * (.5 * amount);
+	state.input = input;
+	state.sum = sum;
+
+	// the antialiased saturation lags half a sample behind the input. only what
+	// the drive adds to the input is lined up with it, against the input delayed
+	// by the same half sample, and the input itself passes straight through. that
+	// way the stages don't delay or dull the signal, and the echoes stay in time
+	auto delayed = (input + lastInput) * .5;
+	return input + (driven - delayed) * mix;
+}
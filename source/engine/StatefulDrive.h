@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Simd.h"
+
+enum class DriveModes
+{
+	standard,
+	antialiased,
+	numDriveModes
+};
+
+// processes both channels at once, each with its own state
+class StatefulDrive
+{
+public:
+	// the most times the drive can be run per sample
+	static const int maxStages = 16;
+
+	void Reset()
+	{
+		previous = 0.0;
+		for (auto &stage : stages) stage = Stage();
+	}
+
+	// each time the drive is run per sample is a separate stage. both modes keep
+	// track of each stage's last input, so the mode can be switched at any time
+	Double2 Process(Double2 input, double amount, int stage);
+
+	// the same drive, but with first order antiderivative antialiasing on the
+	// saturation, which needs to know the stage's input on the last sample
+	Double2 ProcessAntialiased(Double2 input, double amount, int stage);
+
+private:
+	double Saturate(double input, double lastInput, double &lastAntiderivative);
+	double AverageAbs(double input, double lastInput);
+
+	// what each stage had on the last sample
+	struct Stage
+	{
+		Double2 input = 0.0;
+		Double2 sum = 0.0;
+		// per channel. the standard mode doesn't need the antiderivative,
+		// so it leaves it to be worked out again if the mode changes
+		double antiderivative[2] = {};
+		bool antiderivativeCurrent = true;
+	};
+
+	Double2 previous = 0.0;
+	Stage stages[maxStages];
+};
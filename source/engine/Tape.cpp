@@ -0,0 +1,69 @@
+#include "Tape.h"
+#include <algorithm>
+
+void Tape::Init(size_t length, TapeLayout layout, TapePrecision precision, int numChannels)
+{
+	this->numChannels = numChannels == 1 ? 1 : 2;
+	auto frames = Util::nextPowerOfTwo(length);
+	mask = (int)frames - 1;
+	if (this->numChannels == 1)
+	{
+		// both layouts are the same with only one channel
+		frameStride = 1;
+		channelOffset = 0;
+	}
+	else switch (layout)
+	{
+	case TapeLayout::interleaved:
+		frameStride = 2;
+		channelOffset = 1;
+		break;
+	default:
+		frameStride = 1;
+		channelOffset = (int)frames + guardFrames;
+		break;
+	}
+	auto size = (frames + guardFrames) * this->numChannels;
+	singlePrecision = precision == TapePrecision::singlePrecision;
+	if (singlePrecision)
+	{
+		floatData.assign(size, 0.0f);
+		std::vector<double>().swap(data);
+	}
+	else
+	{
+		data.assign(size, 0.0);
+		std::vector<float>().swap(floatData);
+	}
+}
+
+void Tape::CopyFrames(const Tape &other, uint64_t first, int count)
+{
+	while (count > 0)
+	{
+		// goes as far as it can before either tape wraps around
+		auto from = (int)(first & (uint64_t)other.mask);
+		auto to = (int)(first & (uint64_t)mask);
+		auto run = std::min({ count, other.mask + 1 - from, mask + 1 - to });
+		CopyRun(other, from, to, run);
+		if (to < guardFrames) CopyRun(*this, to, mask + 1 + to, std::min(run, guardFrames - to));
+		first += run;
+		count -= run;
+	}
+}
+
+// copies frames that don't wrap around on either tape
+void Tape::CopyRun(const Tape &other, int from, int to, int count)
+{
+	// interleaved frames are contiguous, separate channels are contiguous one at a time
+	auto runs = frameStride == 1 ? numChannels : 1;
+	for (int run = 0; run < runs; run++)
+	{
+		auto source = from * frameStride + run * other.channelOffset;
+		auto destination = to * frameStride + run * channelOffset;
+		if (singlePrecision)
+			std::copy_n(other.floatData.begin() + source, count * frameStride, floatData.begin() + destination);
+		else
+			std::copy_n(other.data.begin() + source, count * frameStride, data.begin() + destination);
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Simd.h"
+#include "Util.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TapeLayout
+{
+	separate, // one contiguous run of samples per channel
+	interleaved // [l, r] frames, so nearby reads on both channels share cache lines
+};
+
+enum class TapePrecision
+{
+	doublePrecision,
+	singlePrecision // halves the memory used by the tape
+};
+
+// Util::interpolate works in single precision, so as long as the filters and the
+// rest of the engine's state stay in double precision, a single precision tape
+// gives the same output as a double precision one.
+
+/*
+
+stereo or mono delay memory. the length is rounded up to a power of two so
+positions can be wrapped with a bitmask, and the first guardFrames frames are
+mirrored past the end so the four interpolation points never need wrapping.
+
+*/
+
+class Tape
+{
+public:
+	void Init(size_t length, TapeLayout layout, TapePrecision precision, int numChannels = 2);
+	bool IsEmpty() const { return data.empty() && floatData.empty(); }
+	size_t GetLength() const { return (size_t)mask + 1; }
+	int GetMask() const { return mask; }
+	int GetNumChannels() const { return numChannels; }
+
+	// copies count frames from other, starting at the frame that's first frames
+	// from the start of the recording. each one lands wherever that frame would
+	// have been written on this tape, so a longer tape can take over from a shorter
+	// one without losing anything. the tapes need the same layout, precision and
+	// number of channels
+	void CopyFrames(const Tape &other, uint64_t first, int count);
+
+	double Read(int channel, double position) const
+	{
+		// the mask also wraps negative positions, since the length is a power of two
+		auto index = (int)floor(position);
+		auto x = position - index;
+		auto offset = ((index - 1) & mask) * frameStride + channel * channelOffset;
+		return singlePrecision ? Interpolate(&floatData[offset], x) : Interpolate(&data[offset], x);
+	}
+
+	// the feedback loop keeps scaling down whatever is on the tape, so anything
+	// small enough to be on its way to subnormal is written as silence
+	void Write(int position, double left, double right)
+	{
+		left = flushToZero(left);
+		right = flushToZero(right);
+		WriteFrame(position, left, right);
+		if (position < guardFrames) WriteFrame(mask + 1 + position, left, right);
+	}
+
+	// for mono tapes
+	void Write(int position, double value)
+	{
+		value = flushToZero(value);
+		WriteSample(position, value);
+		if (position < guardFrames) WriteSample(mask + 1 + position, value);
+	}
+
+private:
+	template<class T>
+	double Interpolate(const T* y, double x) const
+	{
+		return Util::interpolate(x, y[0], y[frameStride], y[frameStride * 2], y[frameStride * 3]);
+	}
+
+	void WriteFrame(int frame, double left, double right)
+	{
+		if (singlePrecision)
+		{
+			floatData[frame * frameStride] = (float)left;
+			floatData[frame * frameStride + channelOffset] = (float)right;
+		}
+		else
+		{
+			data[frame * frameStride] = left;
+			data[frame * frameStride + channelOffset] = right;
+		}
+	}
+
+	void WriteSample(int frame, double value)
+	{
+		if (singlePrecision)
+			floatData[frame] = (float)value;
+		else
+			data[frame] = value;
+	}
+
+	void CopyRun(const Tape &other, int from, int to, int count);
+
+	static const int guardFrames = 3;
+
+	// only one of these is allocated, depending on the precision
+	std::vector<double> data;
+	std::vector<float> floatData;
+	bool singlePrecision = false;
+	int numChannels = 2;
+	int mask = 0;
+	int frameStride = 1;
+	int channelOffset = 0;
+};
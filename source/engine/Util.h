@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace Util
+{
+	const double pi = 2 * acos(0.0);
+
+	inline size_t nextPowerOfTwo(size_t n)
+	{
+		size_t p = 1;
+		while (p < n) p <<= 1;
+		return p;
+	}
+
+	// http://musicdsp.org/archive.php?classid=5#93
+	inline float interpolate(float x, float y0, float y1, float y2, float y3)
+	{
+		// 4-point, 3rd-order Hermite (x-form) 
+		float c0 = y1;
+		float c1 = 0.5f * (y2 - y0);
+		float c2 = y0 - 2.5f * y1 + 2.f * y2 - 0.5f * y3;
+		float c3 = 1.5f * (y1 - y2) + 0.5f * (y3 - y0);
+		return ((c3 * x + c2) * x + c1) * x + c0;
+	}
+
+	// rotates a pair of samples by the angle with cosine c and sine s
+	inline void rotate(double inL, double inR, double c, double s, double &outL, double &outR)
+	{
+		outL = inL * c - inR * s;
+		outR = inL * s + inR * c;
+	}
+}
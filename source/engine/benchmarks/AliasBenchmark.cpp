@@ -0,0 +1,127 @@
+#include "Benchmark.h"
+#include "Oversampler.h"
+#include "StatefulDrive.h"
+#include "Util.h"
+#include <chrono>
+#include <complex>
+#include <initializer_list>
+#include <vector>
+
+/*
+
+offline measurement of how much the drive aliases, and what it costs, for the
+standard drive, the antialiased drive, and the standard drive oversampled.
+
+a sine is driven at a frequency that lands exactly on an fft bin, so all of
+its real harmonics land on multiples of that bin. anything in the other bins
+below 20khz can only be aliasing (or the oversampler's own noise, which is far
+lower). the result is that power relative to the power in the harmonics.
+
+*/
+
+namespace
+{
+	const double sampleRate = 48000.0;
+	const int fftLength = 1 << 16;
+	const int settleLength = 4096;
+
+	void Fft(std::vector<std::complex<double>> &a)
+	{
+		auto n = (int)a.size();
+		for (int i = 1, j = 0; i < n; i++)
+		{
+			auto bit = n >> 1;
+			for (; j & bit; bit >>= 1) j ^= bit;
+			j ^= bit;
+			if (i < j) std::swap(a[i], a[j]);
+		}
+		for (int length = 2; length <= n; length <<= 1)
+		{
+			auto angle = -2 * Util::pi / length;
+			std::complex<double> step(cos(angle), sin(angle));
+			for (int i = 0; i < n; i += length)
+			{
+				std::complex<double> w(1.0);
+				for (int j = 0; j < length / 2; j++)
+				{
+					auto u = a[i + j];
+					auto v = a[i + j + length / 2] * w;
+					a[i + j] = u + v;
+					a[i + j + length / 2] = u - v;
+					w *= step;
+				}
+			}
+		}
+	}
+
+	struct Result
+	{
+		double aliasToSignal; // in db
+		double nanoseconds; // per sample at the original rate
+	};
+
+	Result Measure(DriveModes mode, int oversampling, double gain, int bin)
+	{
+		StatefulDrive drive;
+		Oversampler oversampler;
+		oversampler.Init(oversampling);
+		std::vector<double> output(fftLength + settleLength);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < (int)output.size(); i++)
+		{
+			auto input = .8 * sin(2 * Util::pi * bin * i / fftLength);
+			Double2 samples[Oversampler::maxFactor];
+			oversampler.Upsample(Double2(input), samples);
+			for (int j = 0; j < oversampling; j++)
+			{
+				samples[j] = mode == DriveModes::antialiased
+					? drive.ProcessAntialiased(samples[j] * gain, 1.0, 0)
+					: drive.Process(samples[j] * gain, 1.0, 0);
+				samples[j] *= 1.0 / gain;
+			}
+			output[i] = oversampler.Downsample(samples).Left();
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::vector<std::complex<double>> spectrum(fftLength);
+		for (int i = 0; i < fftLength; i++) spectrum[i] = output[i + settleLength];
+		Fft(spectrum);
+		auto signal = 0.0;
+		auto alias = 0.0;
+		auto lastBin = (int)(fftLength * 20000.0 / sampleRate);
+		for (int b = 1; b < lastBin; b++)
+		{
+			auto power = std::norm(spectrum[b]);
+			if (b % bin == 0)
+				signal += power;
+			else
+				alias += power;
+		}
+
+		Result result;
+		result.aliasToSignal = 10 * log10(alias / signal);
+		result.nanoseconds = elapsed.count() / output.size();
+		return result;
+	}
+}
+
+int main()
+{
+	// about 2.5khz, high enough that the harmonics fold back plenty
+	const int bin = 3413;
+
+	printf("%-12s %4s %6s %16s %10s\n", "mode", "os", "gain", "alias/signal db", "ns/smp");
+	for (auto gain : { 1.0, 3.0, 10.0 })
+	{
+		for (auto oversampling : { 1, 2, 4, 8 })
+		{
+			auto result = Measure(DriveModes::standard, oversampling, gain, bin);
+			printf("%-12s %3dx %6.1f %16.1f %10.1f\n", "standard", oversampling, gain, result.aliasToSignal, result.nanoseconds);
+		}
+		auto result = Measure(DriveModes::antialiased, 1, gain, bin);
+		printf("%-12s %3dx %6.1f %16.1f %10.1f\n", "antialiased", 1, gain, result.aliasToSignal, result.nanoseconds);
+		printf("\n");
+	}
+	return 0;
+}
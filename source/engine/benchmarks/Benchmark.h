@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+
+bits shared by the benchmarks. they're plain executables that print a table,
+so they can be run by hand before and after a change. build them optimized,
+the numbers from a debug build don't say much.
+
+*/
+
+namespace Benchmark
+{
+	// results are stored here so the compiler can't throw away their work
+	inline volatile double sink = 0.0;
+
+	inline void Use(double value)
+	{
+		sink = value;
+	}
+
+	// runs f the given number of times, a few rounds over, and returns the
+	// fastest round in nanoseconds per call. the fastest round is the one
+	// that was interrupted the least
+	template<class F>
+	double Time(F f, long calls, int rounds = 5)
+	{
+		auto best = 0.0;
+		for (int r = 0; r < rounds; r++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (long i = 0; i < calls; i++) f();
+			std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			auto perCall = elapsed.count() / calls;
+			if (r == 0 || perCall < best) best = perCall;
+		}
+		return best;
+	}
+
+	// one hardware event counter for this thread, read through perf_event_open.
+	// it's only there on linux, and only when the kernel lets user code count
+	// events (see /proc/sys/kernel/perf_event_paranoid). IsAvailable says whether it worked
+	class PerfCounter
+	{
+	public:
+		enum class Event
+		{
+			cacheMisses,
+			cacheReferences,
+		};
+
+		explicit PerfCounter(Event event)
+		{
+#if defined(__linux__)
+			perf_event_attr attributes;
+			memset(&attributes, 0, sizeof(attributes));
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.size = sizeof(attributes);
+			attributes.config = event == Event::cacheMisses ? PERF_COUNT_HW_CACHE_MISSES : PERF_COUNT_HW_CACHE_REFERENCES;
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			fd = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+#else
+			(void)event;
+#endif
+		}
+
+		~PerfCounter()
+		{
+#if defined(__linux__)
+			if (fd >= 0) close(fd);
+#endif
+		}
+
+		PerfCounter(const PerfCounter&) = delete;
+		PerfCounter& operator=(const PerfCounter&) = delete;
+
+		bool IsAvailable() const { return fd >= 0; }
+
+		void Start()
+		{
+#if defined(__linux__)
+			if (fd < 0) return;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+		}
+
+		// the number of events since Start
+		uint64_t Stop()
+		{
+			uint64_t count = 0;
+#if defined(__linux__)
+			if (fd < 0) return 0;
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+			return count;
+		}
+
+	private:
+		int fd = -1;
+	};
+}
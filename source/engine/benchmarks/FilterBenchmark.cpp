@@ -0,0 +1,83 @@
+#include "Benchmark.h"
+#include "Filter.h"
+#include <initializer_list>
+
+/*
+
+compares the two ways of running a stereo filter. before, each channel had
+its own scalar filter and worked out its own coefficient, one channel after
+the other. now DualFilter keeps both channels' state in a Double2 and works
+out the coefficient once per sample. both process a chunk of 128 samples
+with a cutoff per sample, the way the engine does.
+
+*/
+
+namespace
+{
+	const int chunkLength = 128;
+	const double dt = 1.0 / 48000.0;
+
+	struct Chunk
+	{
+		double l[chunkLength];
+		double r[chunkLength];
+		double cutoff[chunkLength];
+
+		Chunk()
+		{
+			for (int i = 0; i < chunkLength; i++)
+			{
+				l[i] = sin(i * .1);
+				r[i] = cos(i * .13);
+				cutoff[i] = .5 + .001 * i;
+			}
+		}
+	};
+
+	template<template<class> class Filter>
+	void Run(const char* name, bool highPass)
+	{
+		Chunk chunk;
+
+		Filter<double> left, right;
+		auto scalar = Benchmark::Time([&]
+		{
+			double l[chunkLength], r[chunkLength];
+			for (int i = 0; i < chunkLength; i++)
+			{
+				l[i] = left.Process(dt, chunk.l[i], chunk.cutoff[i], highPass);
+				r[i] = right.Process(dt, chunk.r[i], chunk.cutoff[i], highPass);
+			}
+			Benchmark::Use(l[chunkLength - 1] + r[chunkLength - 1]);
+		}, 100000) / chunkLength;
+
+		DualFilter<Filter> dual;
+		auto simd = Benchmark::Time([&]
+		{
+			double l[chunkLength], r[chunkLength];
+			dual.Process(dt, chunk.l, chunk.r, l, r, chunkLength, chunk.cutoff, highPass);
+			Benchmark::Use(l[chunkLength - 1] + r[chunkLength - 1]);
+		}, 100000) / chunkLength;
+
+		printf("%-16s %-5s %12.2f %12.2f %7.2fx\n", name, highPass ? "hp" : "lp", scalar, simd, scalar / simd);
+	}
+}
+
+int main()
+{
+#ifdef COCOA_DELAY_SSE2
+	printf("Double2 is using sse2\n\n");
+#else
+	printf("Double2 is using the scalar fallback\n\n");
+#endif
+	printf("%-16s %-5s %12s %12s %8s\n", "filter", "", "scalar ns", "dual ns", "speedup");
+	for (auto highPass : { false, true })
+	{
+		Run<OnePoleFilter>("one pole", highPass);
+		Run<TwoPoleFilter>("two pole", highPass);
+		Run<FourPoleFilter>("four pole", highPass);
+		Run<StateVariableFilter>("state variable", highPass);
+	}
+	printf("\nns are per stereo sample\n");
+	return 0;
+}
@@ -0,0 +1,116 @@
+#include "Benchmark.h"
+#include "CocoaDelayEngine.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <thread>
+#include <vector>
+
+/*
+
+runs several instances on their own threads, the way a host with a worker
+pool does, to show that the drift noise no longer makes them fight over
+shared state.
+
+the first table compares the generators on their own: the old xorshift,
+whose state was shared by every instance, against one Random per instance.
+the shared state is kept in relaxed atomics here so the benchmark doesn't
+have a data race of its own, but the loads and stores bounce the cache line
+between cores just like the plain globals did. the second table runs whole
+engines, one per thread.
+
+*/
+
+namespace
+{
+	// the old generator from Util.h
+	std::atomic<unsigned long> sharedX{ 123456789 }, sharedY{ 362436069 }, sharedZ{ 521288629 };
+
+	double SharedRandom()
+	{
+		auto x = sharedX.load(std::memory_order_relaxed);
+		auto y = sharedY.load(std::memory_order_relaxed);
+		auto z = sharedZ.load(std::memory_order_relaxed);
+		x ^= x << 16;
+		x ^= x >> 5;
+		x ^= x << 1;
+		auto t = x;
+		x = y;
+		y = z;
+		z = t ^ x ^ y;
+		sharedX.store(x, std::memory_order_relaxed);
+		sharedY.store(y, std::memory_order_relaxed);
+		sharedZ.store(z, std::memory_order_relaxed);
+		return -1.0 + z * (2.0 / ULONG_MAX);
+	}
+
+	// runs work on each of numThreads threads at once, and returns the wall time in ms
+	template<class F>
+	double RunThreads(int numThreads, F work)
+	{
+		std::vector<std::thread> threads;
+		auto start = std::chrono::steady_clock::now();
+		for (int t = 0; t < numThreads; t++) threads.emplace_back(work, t);
+		for (auto &thread : threads) thread.join();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	// one second of stereo audio at 48khz per thread
+	double RunEngines(int numThreads)
+	{
+		return RunThreads(numThreads, [](int t)
+		{
+			const int blockSize = 256;
+			CocoaDelayEngine engine;
+			EngineParameters parameters;
+			parameters.driftAmount = .01;
+			engine.SetParameters(parameters);
+			engine.Reset(48000.0);
+			std::vector<double> left(blockSize), right(blockSize);
+			double* buffers[2] = { left.data(), right.data() };
+			Random random(t);
+			for (int b = 0; b < 48000 / blockSize; b++)
+			{
+				for (int i = 0; i < blockSize; i++) left[i] = right[i] = random.Bipolar() * .5;
+				engine.Process(buffers, buffers, blockSize);
+			}
+			Benchmark::Use(left[0]);
+		});
+	}
+}
+
+int main()
+{
+	const long calls = 10000000;
+	auto maxThreads = (int)std::thread::hardware_concurrency();
+	if (maxThreads < 2) maxThreads = 2;
+
+	printf("%d hardware threads\n\n", (int)std::thread::hardware_concurrency());
+	printf("%-8s %18s %18s\n", "threads", "shared ms", "per instance ms");
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		auto shared = RunThreads(numThreads, [](int)
+		{
+			auto sum = 0.0;
+			for (long i = 0; i < calls; i++) sum += SharedRandom();
+			Benchmark::Use(sum);
+		});
+		auto perInstance = RunThreads(numThreads, [](int t)
+		{
+			Random random(t);
+			auto sum = 0.0;
+			for (long i = 0; i < calls; i++) sum += random.Bipolar();
+			Benchmark::Use(sum);
+		});
+		printf("%-8d %18.1f %18.1f\n", numThreads, shared, perInstance);
+	}
+
+	// a first run, so the timed ones don't include the process warming up
+	RunEngines(1);
+	printf("\n%-8s %18s\n", "engines", "ms per second");
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+		printf("%-8d %18.1f\n", numThreads, RunEngines(numThreads));
+	printf("\neach thread does the same work, so with enough cores the times should stay flat\n");
+	return 0;
+}
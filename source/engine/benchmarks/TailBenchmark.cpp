@@ -0,0 +1,88 @@
+#include "Benchmark.h"
+#include "CocoaDelayEngine.h"
+#include "Denormals.h"
+#include <chrono>
+#include <vector>
+
+/*
+
+measures the cost of each block while a feedback tail decays for 60 seconds
+after a short burst, with and without the flush to zero guard the iplug
+callback uses. without any protection, the later blocks would get slower as
+the tail sinks into subnormals. with feedback at .95 and a .2 second delay,
+the tail takes about a minute to fall below the engine's silence threshold.
+
+*/
+
+namespace
+{
+	const double sampleRate = 48000.0;
+	const int blockSize = 256;
+	const int seconds = 60;
+	const int windowSeconds = 5;
+
+	struct Window
+	{
+		double mean = 0.0;
+		double max = 0.0;
+		int idleBlocks = 0;
+	};
+
+	std::vector<Window> Run(bool guard)
+	{
+		CocoaDelayEngine engine;
+		EngineParameters parameters;
+		parameters.feedback = .95;
+		parameters.driftAmount = 0.0;
+		engine.SetParameters(parameters);
+		engine.Reset(sampleRate);
+
+		std::vector<double> left(blockSize), right(blockSize);
+		double* buffers[2] = { left.data(), right.data() };
+		Random random(1);
+
+		auto blocksPerWindow = (int)(windowSeconds * sampleRate / blockSize);
+		auto numWindows = seconds / windowSeconds;
+		std::vector<Window> windows(numWindows);
+		for (int b = 0; b < blocksPerWindow * numWindows; b++)
+		{
+			// a tenth of a second of noise, then silence
+			auto burst = b * blockSize < sampleRate * .1;
+			for (int i = 0; i < blockSize; i++)
+				left[i] = right[i] = burst ? random.Bipolar() * .5 : 0.0;
+
+			auto start = std::chrono::steady_clock::now();
+			if (guard)
+			{
+				ScopedFlushDenormals flushDenormals;
+				engine.Process(buffers, buffers, blockSize);
+			}
+			else
+				engine.Process(buffers, buffers, blockSize);
+			std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+			auto &window = windows[b / blocksPerWindow];
+			window.mean += elapsed.count() / blocksPerWindow;
+			window.max = fmax(window.max, elapsed.count());
+			if (engine.IsIdle()) window.idleBlocks++;
+			Benchmark::Use(left[0]);
+		}
+		return windows;
+	}
+}
+
+int main()
+{
+	auto withGuard = Run(true);
+	auto withoutGuard = Run(false);
+	printf("us per %d sample block at %.0fhz\n\n", blockSize, sampleRate);
+	printf("%-9s %24s %24s\n", "", "flush to zero", "engine flushing only");
+	printf("%-9s %8s %8s %6s %8s %8s %6s\n", "seconds", "mean", "max", "idle", "mean", "max", "idle");
+	for (size_t w = 0; w < withGuard.size(); w++)
+	{
+		printf("%3d - %-3d %8.1f %8.1f %6d %8.1f %8.1f %6d\n", (int)w * windowSeconds, (int)(w + 1) * windowSeconds,
+			withGuard[w].mean, withGuard[w].max, withGuard[w].idleBlocks,
+			withoutGuard[w].mean, withoutGuard[w].max, withoutGuard[w].idleBlocks);
+	}
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+#include "Tape.h"
+
+/*
+
+compares the separate and interleaved tape layouts across stereo offsets.
+each sample reads both channels at the engine's offset read positions and
+writes a frame, the way the engine uses the tape. the tape is 10 seconds at
+192khz, which is far bigger than the caches, so the misses show up. cache
+misses are counted with perf counters where the system allows it.
+
+*/
+
+namespace
+{
+	struct Result
+	{
+		double nanoseconds;
+		double missesPerSample; // negative if the counter isn't available
+	};
+
+	Result Run(TapeLayout layout, double stereoOffset)
+	{
+		const double sampleRate = 192000.0;
+		const double delayTime = .5;
+		const long samples = 1 << 22;
+
+		Tape tape;
+		tape.Init((size_t)(10 * sampleRate), layout, TapePrecision::doublePrecision);
+		auto readOffsetL = pow(delayTime, 1.0 + stereoOffset * .5) * sampleRate + .37;
+		auto readOffsetR = pow(delayTime, 1.0 - stereoOffset * .5) * sampleRate + .37;
+
+		int writePosition = 0;
+		auto step = [&]
+		{
+			auto l = tape.Read(0, writePosition - readOffsetL);
+			auto r = tape.Read(1, writePosition - readOffsetR);
+			tape.Write(writePosition, l * .5 + .1, r * .5 - .1);
+			writePosition = (writePosition + 1) & tape.GetMask();
+		};
+
+		// fills the tape once, so the timed rounds aren't reading pages for the first time
+		for (size_t i = 0; i < tape.GetLength(); i++) step();
+
+		Result result;
+		result.nanoseconds = Benchmark::Time(step, samples);
+
+		Benchmark::PerfCounter misses(Benchmark::PerfCounter::Event::cacheMisses);
+		if (misses.IsAvailable())
+		{
+			misses.Start();
+			for (long i = 0; i < samples; i++) step();
+			result.missesPerSample = (double)misses.Stop() / samples;
+		}
+		else
+			result.missesPerSample = -1.0;
+		return result;
+	}
+
+	void Print(const char* name, double offset, Result result)
+	{
+		if (result.missesPerSample < 0.0)
+			printf("%-12s %8.2f %10.2f %16s\n", name, offset, result.nanoseconds, "n/a");
+		else
+			printf("%-12s %8.2f %10.2f %16.4f\n", name, offset, result.nanoseconds, result.missesPerSample);
+	}
+}
+
+int main()
+{
+	printf("%-12s %8s %10s %16s\n", "layout", "offset", "ns/smp", "misses/smp");
+	for (auto offset : { 0.0, .01, .05, .2, .5 })
+	{
+		Print("separate", offset, Run(TapeLayout::separate, offset));
+		Print("interleaved", offset, Run(TapeLayout::interleaved, offset));
+	}
+	if (!Benchmark::PerfCounter(Benchmark::PerfCounter::Event::cacheMisses).IsAvailable())
+		printf("\ncache miss counts weren't available. they need linux with perf_event_open access to a hardware pmu\n");
+	return 0;
+}
@@ -0,0 +1,82 @@
+#include "Benchmark.h"
+#include "Tape.h"
+#include <vector>
+
+/*
+
+compares reading the tape through the power of two mask with the way it was
+read before, where each of the four interpolation points was wrapped into
+range with an integer modulo and a branch.
+
+*/
+
+namespace
+{
+	// the old read path
+	int Wrap(int kX, int const kLowerBound, int const kUpperBound)
+	{
+		int range_size = kUpperBound - kLowerBound + 1;
+
+		if (kX < kLowerBound)
+			kX += range_size * ((kLowerBound - kX) / range_size + 1);
+
+		return kLowerBound + (kX - kLowerBound) % range_size;
+	}
+
+	double GetSample(const std::vector<double> &buffer, double position)
+	{
+		int size = (int)buffer.size();
+		int p0 = Wrap((int)floor(position) - 1, 0, size - 1);
+		int p1 = Wrap((int)floor(position), 0, size - 1);
+		int p2 = Wrap((int)ceil(position), 0, size - 1);
+		int p3 = Wrap((int)ceil(position) + 1, 0, size - 1);
+		auto x = position - floor(position);
+		return Util::interpolate((float)x, (float)buffer[p0], (float)buffer[p1], (float)buffer[p2], (float)buffer[p3]);
+	}
+}
+
+int main()
+{
+	const double sampleRate = 48000.0;
+	const int length = 10 * 48000;
+	const long samples = 1 << 22;
+
+	std::vector<double> bufferL(length), bufferR(length);
+	Tape tape;
+	tape.Init(length, TapeLayout::separate, TapePrecision::doublePrecision);
+	for (int i = 0; i < length; i++)
+	{
+		auto value = sin(i * .001);
+		bufferL[i] = bufferR[i] = value;
+		tape.Write(i & tape.GetMask(), value, value);
+	}
+
+	printf("%-12s %14s %14s %8s\n", "delay", "wrap ns/smp", "mask ns/smp", "speedup");
+	for (auto delay : { .001, .2, 2.0, 8.0 })
+	{
+		// the fractional part keeps the interpolation doing real work
+		auto readOffset = delay * sampleRate + .37;
+
+		int oldWrite = 0;
+		auto oldTime = Benchmark::Time([&]
+		{
+			auto l = GetSample(bufferL, oldWrite - readOffset);
+			auto r = GetSample(bufferR, oldWrite - readOffset * 1.01);
+			Benchmark::Use(l + r);
+			oldWrite++;
+			oldWrite %= length;
+		}, samples);
+
+		int newWrite = 0;
+		auto newTime = Benchmark::Time([&]
+		{
+			auto l = tape.Read(0, newWrite - readOffset);
+			auto r = tape.Read(1, newWrite - readOffset * 1.01);
+			Benchmark::Use(l + r);
+			newWrite = (newWrite + 1) & tape.GetMask();
+		}, samples);
+
+		printf("%-10.3f s %14.2f %14.2f %7.2fx\n", delay, oldTime, newTime, oldTime / newTime);
+	}
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include "TestUtil.h"
+
+/*
+
+checks that the channel layouts agree with each other. a mono engine has to
+behave like the left channel of a stereo engine whose right input is silent,
+stereo offset included, and the odd channel at the end of a larger engine
+has to behave like a mono engine. in 5.1, the centre and lfe are grouped on
+their own, so each of them has to behave like a mono engine too.
+
+*/
+
+namespace
+{
+	std::vector<double> RenderChannels(int numChannels, const EngineParameters &parameters, const std::vector<std::vector<double>> &inputs,
+		std::vector<ChannelGroup> groups = {})
+	{
+		EngineConfig config;
+		config.numChannels = numChannels;
+		for (auto group : groups) config.channelGroups[config.numChannelGroups++] = group;
+		config.reproducible = true;
+		config.seed = 7;
+		auto engine = Test::MakeEngine(config, parameters);
+		return Test::Render(engine, inputs);
+	}
+
+	std::vector<double> GetChannel(const std::vector<double> &output, int channel, int length)
+	{
+		return std::vector<double>(output.begin() + channel * length, output.begin() + (channel + 1) * length);
+	}
+}
+
+int main()
+{
+	const int length = 48000 * 2;
+	auto input = Test::MakeInput(length, 1);
+	std::vector<double> silence(length, 0.0);
+
+	// l, r, c, lfe, ls, rs, grouped the way the juce front end does it
+	std::vector<ChannelGroup> surroundGroups(4);
+	surroundGroups[0].left = 0;
+	surroundGroups[0].right = 1;
+	surroundGroups[1].left = 2;
+	surroundGroups[2].left = 3;
+	surroundGroups[3].left = 4;
+	surroundGroups[3].right = 5;
+
+	for (auto preset : Test::LoadPresets())
+	{
+		// the panning moves the left channel's echoes into the right, which a mono
+		// engine doesn't have, so it's centered and stationary for the comparison
+		auto parameters = preset.parameters;
+		parameters.panMode = PanModes::stationary;
+		parameters.pan = 0.0;
+		for (auto stereoOffset : { 0.0, -.4, .4 })
+		{
+			parameters.stereoOffset = stereoOffset;
+			auto name = preset.name + " with stereo offset " + Test::ToString(stereoOffset);
+
+			auto mono = RenderChannels(1, parameters, { input });
+			auto stereo = RenderChannels(2, parameters, { input, silence });
+			auto difference = Test::PeakDifference(mono, GetChannel(stereo, 0, length));
+			Test::Check(difference < 1e-12, name + ": mono differs from the left channel of stereo by " + Test::ToString(difference));
+
+			auto three = RenderChannels(3, parameters, { silence, silence, input });
+			difference = Test::PeakDifference(mono, GetChannel(three, 2, length));
+			Test::Check(difference < 1e-12, name + ": the third of three channels differs from mono by " + Test::ToString(difference));
+
+			for (auto channel : { 2, 3 })
+			{
+				std::vector<std::vector<double>> inputs(6, silence);
+				inputs[channel] = input;
+				auto surround = RenderChannels(6, parameters, inputs, surroundGroups);
+				difference = Test::PeakDifference(mono, GetChannel(surround, channel, length));
+				Test::Check(difference < 1e-12, name + ": 5.1 channel " + std::to_string(channel + 1) + " differs from mono by " + Test::ToString(difference));
+			}
+		}
+	}
+	return Test::Finish();
+}
@@ -0,0 +1,165 @@
+#include "TestUtil.h"
+#include "StatefulDrive.h"
+
+/*
+
+checks the two lane drive against a plain per channel version of the same
+algorithm that uses std::sin. the channels get different signals, so any
+state leaking from one to the other shows up as a difference.
+
+the antialiased drive is checked against the standard one: switching modes
+mustn't jump, and at a low gain it has to leave the echoes' timing and level
+alone, since all it's meant to change is the aliasing.
+
+*/
+
+namespace
+{
+	// one channel of the drive, written the simple way
+	class ReferenceDrive
+	{
+	public:
+		double Process(double input, double amount)
+		{
+			auto driven = input == 0.0 ? 0.0 : sin(input * input) / input;
+			auto mix = fabs(previous + driven) * .5 * amount;
+			previous = driven;
+			return input * (1.0 - mix) + driven * mix;
+		}
+
+	private:
+		double previous = 0.0;
+	};
+
+	// fastSin has to stay close to std::sin over the whole range of doubles,
+	// including past where its own range reduction gives out
+	void TestFastSin()
+	{
+		Random random(1);
+		for (auto magnitude = 1.0; magnitude < 1e15; magnitude *= 10)
+		{
+			auto worst = 0.0;
+			for (int i = 0; i < 100000; i++)
+			{
+				auto l = random.Bipolar() * magnitude;
+				auto r = random.Bipolar() * magnitude;
+				auto result = fastSin(Double2(l, r));
+				worst = fmax(worst, fmax(fabs(result.Left() - sin(l)), fabs(result.Right() - sin(r))));
+			}
+			Test::Check(worst < 1e-9, "fastSin is off by " + Test::ToString(worst) + " for inputs up to " + Test::ToString(magnitude));
+		}
+	}
+
+	// runs the drive the way the engine does, with the gain applied before and
+	// taken off after, for a number of iterations. at high gains the drive is
+	// chaotic, so the reference starts each iteration from the drive's last
+	// output rather than its own, which would drift apart from tiny differences
+	void TestDrive(double gain, double mix, int iterations, double level)
+	{
+		StatefulDrive drive;
+		ReferenceDrive left, right;
+		Random random(2);
+		auto worst = 0.0;
+		for (int i = 0; i < 48000; i++)
+		{
+			// the right channel is quieter and goes silent partway through
+			auto l = random.Bipolar() * level;
+			auto r = i < 24000 ? sin(i * .01) * level * .3 : 0.0;
+			auto out = Double2(l, r);
+			for (int j = 0; j < iterations; j++)
+			{
+				l = left.Process(out.Left() * gain, mix) / gain;
+				r = right.Process(out.Right() * gain, mix) / gain;
+				out = drive.Process(out * gain, mix, j) * (1.0 / gain);
+				worst = fmax(worst, fmax(fabs(out.Left() - l), fabs(out.Right() - r)) / level);
+			}
+		}
+		Test::Check(worst < 1e-8, "drive with gain " + Test::ToString(gain) + ", " + Test::ToString(iterations)
+			+ " iterations and level " + Test::ToString(level) + " is off by a relative " + Test::ToString(worst));
+	}
+
+	// the output just after switching to the antialiased mode, compared with a
+	// drive that was antialiased all along
+	void TestModeSwitch()
+	{
+		const double gain = 3.0;
+		const int switchSample = 500;
+		StatefulDrive switched, antialiased;
+		auto worst = 0.0;
+		for (int i = 0; i < switchSample + 100; i++)
+		{
+			auto input = Double2(sin(i * .05), sin(i * .03) * .5) * gain;
+			auto reference = antialiased.ProcessAntialiased(input, 1.0, 0);
+			if (i < switchSample)
+			{
+				switched.Process(input, 1.0, 0);
+				continue;
+			}
+			auto out = switched.ProcessAntialiased(input, 1.0, 0);
+			worst = fmax(worst, fmax(fabs(out.Left() - reference.Left()), fabs(out.Right() - reference.Right())));
+		}
+		Test::Check(worst < .01, "switching to the antialiased drive is off by " + Test::ToString(worst));
+	}
+
+	// renders an impulse through a drive at low gain, dry signal off
+	std::vector<double> RenderEchoes(DriveModes mode, int iterations, int oversampling, int length)
+	{
+		EngineParameters parameters;
+		parameters.delayTime = .05;
+		parameters.feedback = .8;
+		parameters.driftAmount = 0.0;
+		parameters.driveGain = .1;
+		parameters.driveIterations = iterations;
+		parameters.driveMode = mode;
+		parameters.oversampling = oversampling;
+		parameters.dryVolume = 0.0;
+		parameters.wetVolume = 1.0;
+		auto engine = Test::MakeEngine(EngineConfig(), parameters);
+		std::vector<double> input(length, 0.0);
+		input[0] = 1.0;
+		return Test::Render(engine, { input, input });
+	}
+
+	void TestEchoes(int iterations, int oversampling)
+	{
+		const int delay = 2400; // .05 seconds at 48khz
+		const int numEchoes = 5;
+		auto length = delay * (numEchoes + 1);
+		auto standard = RenderEchoes(DriveModes::standard, iterations, oversampling, length);
+		auto antialiased = RenderEchoes(DriveModes::antialiased, iterations, oversampling, length);
+		auto name = Test::ToString(iterations) + " iterations at " + Test::ToString(oversampling) + "x";
+		for (int echo = 1; echo <= numEchoes; echo++)
+		{
+			int peaks[2] = {};
+			double levels[2] = {};
+			for (int i = echo * delay - delay / 2; i < echo * delay + delay / 2; i++)
+			{
+				if (fabs(standard[i]) > levels[0]) levels[0] = fabs(standard[i]), peaks[0] = i;
+				if (fabs(antialiased[i]) > levels[1]) levels[1] = fabs(antialiased[i]), peaks[1] = i;
+			}
+			Test::Check(peaks[0] == peaks[1], name + ": echo " + Test::ToString(echo) + " lands "
+				+ Test::ToString(peaks[1] - peaks[0]) + " samples away from the standard drive's");
+		}
+
+		// at this gain the two drives should be all but identical, level included
+		auto difference = Test::ToDecibels(Test::PeakDifference(standard, antialiased));
+		Test::Check(difference < -100.0, name + ": the antialiased drive differs from the standard one by " + Test::ToString(difference) + " db");
+	}
+}
+
+int main()
+{
+	TestFastSin();
+	TestModeSwitch();
+	for (auto iterations : { 1, 16 })
+		for (auto oversampling : { 1, 2 })
+			TestEchoes(iterations, oversampling);
+	for (auto gain : { .1, 1.0, 10.0 })
+		for (auto iterations : { 1, 4, 16 })
+			TestDrive(gain, 1.0, iterations, 1.0);
+	TestDrive(3.0, .5, 4, 1.0);
+
+	// big enough that the sine's input goes past the fast range reduction
+	TestDrive(10.0, 1.0, 1, 1e4);
+	return Test::Finish();
+}
@@ -0,0 +1,53 @@
+#include "TestUtil.h"
+
+/*
+
+once the tail has died away the engine goes idle and only applies the dry
+volume. hosts can hand over the same buffers for input and output in any
+order, so the idle path has to read every input before writing any output,
+like the normal path does.
+
+*/
+
+int main()
+{
+	const int blockSize = 256;
+	const double quiet = 5e-8; // below the silence threshold, so the engine stays idle
+
+	CocoaDelayEngine engine;
+	EngineParameters parameters;
+	parameters.delayTime = .01;
+	parameters.feedback = .3;
+	parameters.dryVolume = .5;
+	engine.SetParameters(parameters);
+	engine.Reset(48000.0);
+
+	std::vector<double> a(blockSize), b(blockSize);
+	for (int block = 0; block < 200 && !engine.IsIdle(); block++)
+	{
+		for (int i = 0; i < blockSize; i++) a[i] = b[i] = block == 0 ? .5 : 0.0;
+		double* buffers[2] = { a.data(), b.data() };
+		engine.Process(buffers, buffers, blockSize);
+	}
+	Test::Check(engine.IsIdle(), "the engine didn't go idle after the tail died away");
+
+	// each output points to the other channel's input
+	for (int i = 0; i < blockSize; i++)
+	{
+		a[i] = quiet;
+		b[i] = -quiet * .5;
+	}
+	const double* inputs[2] = { a.data(), b.data() };
+	double* outputs[2] = { b.data(), a.data() };
+	engine.Process(inputs, outputs, blockSize);
+	Test::Check(engine.IsIdle(), "the engine woke up for an input below the silence threshold");
+
+	auto worst = 0.0;
+	for (int i = 0; i < blockSize; i++)
+	{
+		worst = fmax(worst, fabs(b[i] - quiet * .5));
+		worst = fmax(worst, fabs(a[i] + quiet * .5 * .5));
+	}
+	Test::Check(worst < 1e-20, "idle output with crossed buffers is off by " + Test::ToString(worst));
+	return Test::Finish();
+}
@@ -0,0 +1,55 @@
+#include "TestUtil.h"
+
+/*
+
+with reproducible drift on, rendering the same input from a Reset has to give
+the same output to the bit, whether it's a new engine or the same one reset.
+different seeds have to give different drift, or the seed wouldn't be doing
+anything.
+
+*/
+
+namespace
+{
+	CocoaDelayEngine MakeEngine(const EngineParameters &parameters, uint64_t seed)
+	{
+		EngineConfig config;
+		config.reproducible = true;
+		config.seed = seed;
+		return Test::MakeEngine(config, parameters);
+	}
+
+	std::vector<double> RenderNew(const EngineParameters &parameters, uint64_t seed, const std::vector<std::vector<double>> &inputs)
+	{
+		auto engine = MakeEngine(parameters, seed);
+		return Test::Render(engine, inputs);
+	}
+}
+
+int main()
+{
+	const int length = 48000 * 2;
+	std::vector<std::vector<double>> inputs = { Test::MakeInput(length, 1), Test::MakeInput(length, 2) };
+
+	for (auto preset : Test::LoadPresets())
+	{
+		// plenty of drift, so a different seed is sure to be heard
+		auto parameters = preset.parameters;
+		parameters.driftAmount = .01;
+
+		auto first = RenderNew(parameters, 42, inputs);
+		auto second = RenderNew(parameters, 42, inputs);
+		Test::Check(first == second, preset.name + ": two engines with the same seed rendered differently");
+
+		// an engine that's already been used has to start over on Reset
+		auto engine = MakeEngine(parameters, 42);
+		Test::Render(engine, inputs);
+		engine.Reset(48000.0);
+		auto afterReset = Test::Render(engine, inputs);
+		Test::Check(first == afterReset, preset.name + ": rendering again after a reset gave a different result");
+
+		auto otherSeed = RenderNew(parameters, 43, inputs);
+		Test::Check(first != otherSeed, preset.name + ": different seeds rendered the same");
+	}
+	return Test::Finish();
+}
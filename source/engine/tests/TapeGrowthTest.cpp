@@ -0,0 +1,95 @@
+#include "TestUtil.h"
+
+/*
+
+the tape is sized in Reset for the tempo at the time, so a synced delay can
+outgrow it if the host slows down. UpdateTape, called off the audio thread,
+makes a longer one, and what's on the old tape is copied over a block at a
+time until the new one can be swapped in. the echoes have to land on time
+after that, and nothing already on the tape can be lost on the way.
+
+*/
+
+namespace
+{
+	const double sampleRate = 48000.0;
+
+	EngineParameters GetParameters(TempoSyncTimes tempoSyncTime, double delayTime)
+	{
+		EngineParameters parameters;
+		parameters.tempoSyncTime = tempoSyncTime;
+		parameters.delayTime = delayTime;
+		parameters.driftAmount = 0.0;
+		parameters.dryVolume = 0.0;
+		parameters.wetVolume = 1.0;
+		return parameters;
+	}
+
+	// renders an impulse, and returns where the first echo in the left channel peaks
+	int FindFirstEcho(CocoaDelayEngine &engine, int length)
+	{
+		std::vector<double> input(length, 0.0);
+		input[0] = 1.0;
+		auto output = Test::Render(engine, { input, input });
+		auto peak = 0;
+		for (int i = 0; i < length; i++)
+			if (fabs(output[i]) > fabs(output[peak])) peak = i;
+		return peak;
+	}
+
+	// a whole note at 40 bpm is 6 seconds, much more than a tape sized at 120 bpm holds
+	void TestSlowerTempo()
+	{
+		const int expected = (int)(6.0 * sampleRate);
+		auto parameters = GetParameters(TempoSyncTimes::whole, .2);
+
+		auto engine = Test::MakeEngine(EngineConfig(), parameters, sampleRate);
+		engine.SetTempo(40.0, false);
+		engine.UpdateTape();
+		auto echo = FindFirstEcho(engine, expected + 4800);
+		Test::Check(abs(echo - expected) <= 1, "after slowing down, the echo lands at " + Test::ToString(echo / sampleRate) + " seconds instead of 6");
+
+		// with no tempo yet at the Reset, the tape has to be long enough for any tempo
+		CocoaDelayEngine unknownTempo;
+		unknownTempo.SetParameters(parameters);
+		unknownTempo.Reset(sampleRate);
+		unknownTempo.SetTempo(40.0, false);
+		echo = FindFirstEcho(unknownTempo, expected + 4800);
+		Test::Check(abs(echo - expected) <= 1, "with the tempo unknown at the reset, the echo lands at " + Test::ToString(echo / sampleRate) + " seconds instead of 6");
+	}
+
+	// a second long unsynced delay, with the tape growing growAfter seconds in. the
+	// tempo doesn't change the delay time, so it has to sound the same as if the
+	// tape had never grown
+	void TestHistoryKept(double growAfter)
+	{
+		const int growAt = (int)(growAfter * sampleRate);
+		const int length = growAt + (int)(.7 * sampleRate);
+		auto parameters = GetParameters(TempoSyncTimes::tempoSyncOff, 1.0);
+		auto input = Test::MakeInput(length, 1);
+
+		auto reference = Test::MakeEngine(EngineConfig(), parameters, sampleRate);
+		auto expected = Test::Render(reference, { input, input });
+
+		auto engine = Test::MakeEngine(EngineConfig(), parameters, sampleRate);
+		std::vector<double> first(input.begin(), input.begin() + growAt), second(input.begin() + growAt, input.end());
+		auto before = Test::Render(engine, { first, first });
+		engine.SetTempo(30.0, false);
+		engine.UpdateTape();
+		auto after = Test::Render(engine, { second, second });
+
+		std::vector<double> left(before.begin(), before.begin() + growAt);
+		left.insert(left.end(), after.begin(), after.begin() + (length - growAt));
+		auto difference = Test::PeakDifference(std::vector<double>(expected.begin(), expected.begin() + length), left);
+		Test::Check(difference < 1e-12, "growing the tape after " + Test::ToString(growAfter) + " seconds changed the output by " + Test::ToString(difference));
+	}
+}
+
+int main()
+{
+	TestSlowerTempo();
+	// before the first echo, and after the old tape has gone all the way around
+	TestHistoryKept(.5);
+	TestHistoryKept(6.0);
+	return Test::Finish();
+}
@@ -0,0 +1,41 @@
+#include "TestUtil.h"
+
+/*
+
+null test between the single and double precision tapes. the interpolator
+already works in single precision, so storing the tape as floats should
+only make a difference far below anything audible. every factory preset
+has to stay under -120 dbfs.
+
+*/
+
+namespace
+{
+	std::vector<double> RenderPreset(const EngineParameters &parameters, TapePrecision precision, const std::vector<std::vector<double>> &inputs)
+	{
+		EngineConfig config;
+		config.tapePrecision = precision;
+		// the drift noise has to be the same in both renders
+		config.reproducible = true;
+		config.seed = 1;
+		auto engine = Test::MakeEngine(config, parameters);
+		return Test::Render(engine, inputs);
+	}
+}
+
+int main()
+{
+	const double threshold = -120.0;
+	const int length = 48000 * 4;
+	std::vector<std::vector<double>> inputs = { Test::MakeInput(length, 1), Test::MakeInput(length, 2) };
+
+	for (auto &preset : Test::LoadPresets())
+	{
+		auto doubleTape = RenderPreset(preset.parameters, TapePrecision::doublePrecision, inputs);
+		auto floatTape = RenderPreset(preset.parameters, TapePrecision::singlePrecision, inputs);
+		auto difference = Test::ToDecibels(Test::PeakDifference(doubleTape, floatTape));
+		printf("%-20s %8.1f dbfs\n", preset.name.c_str(), difference);
+		Test::Check(difference < threshold, preset.name + " differs by more than -120 dbfs");
+	}
+	return Test::Finish();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "CocoaDelayEngine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+
+bits shared by the engine tests. each test is its own executable that
+returns nonzero if anything failed, which is all ctest looks at.
+
+*/
+
+namespace Test
+{
+	inline int failures = 0;
+
+	inline void Check(bool condition, const std::string &message)
+	{
+		if (condition) return;
+		printf("FAILED: %s\n", message.c_str());
+		failures++;
+	}
+
+	// std::to_string rounds small numbers to zero
+	inline std::string ToString(double value)
+	{
+		char text[32];
+		snprintf(text, sizeof(text), "%g", value);
+		return text;
+	}
+
+	inline int Finish()
+	{
+		if (failures == 0) printf("all passed\n");
+		return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	struct Preset
+	{
+		std::string name;
+		EngineParameters parameters;
+	};
+
+	// reads the factory presets out of Presets.cpp, so the tests always cover
+	// the ones that ship. Presets.cpp is written against iplug, so it's parsed
+	// rather than compiled. parameters a preset doesn't name keep their defaults
+	inline std::vector<Preset> LoadPresets()
+	{
+		std::vector<Preset> presets;
+		presets.push_back({ "Init", EngineParameters() });
+
+		std::ifstream file(COCOA_DELAY_PRESETS_PATH);
+		if (!file)
+		{
+			Check(false, std::string("couldn't open ") + COCOA_DELAY_PRESETS_PATH);
+			return presets;
+		}
+		std::stringstream contents;
+		contents << file.rdbuf();
+		auto text = contents.str();
+
+		const std::string presetStart = "MakePresetFromNamedParams(\"";
+		const std::string parameterStart = "(int)Parameters::";
+		size_t position = 0;
+		while ((position = text.find(presetStart, position)) != std::string::npos)
+		{
+			position += presetStart.size();
+			Preset preset;
+			preset.name = text.substr(position, text.find('"', position) - position);
+			auto end = text.find(");", position);
+			while (true)
+			{
+				auto p = text.find(parameterStart, position);
+				if (p == std::string::npos || p > end) break;
+				p += parameterStart.size();
+				auto comma = text.find(',', p);
+				auto name = text.substr(p, comma - p);
+				auto value = strtod(text.c_str() + comma + 1, nullptr);
+				position = comma + 1;
+
+				auto &parameters = preset.parameters;
+				if (name == "delayTime") parameters.delayTime = value;
+				else if (name == "lfoAmount") parameters.lfoAmount = value;
+				else if (name == "lfoFrequency") parameters.lfoFrequency = value;
+				else if (name == "driftAmount") parameters.driftAmount = value;
+				else if (name == "driftSpeed") parameters.driftSpeed = value;
+				else if (name == "tempoSyncTime") parameters.tempoSyncTime = (TempoSyncTimes)(int)value;
+				else if (name == "feedback") parameters.feedback = value;
+				else if (name == "stereoOffset") parameters.stereoOffset = value;
+				else if (name == "panMode") parameters.panMode = (PanModes)(int)value;
+				else if (name == "pan") parameters.pan = value;
+				else if (name == "duckAmount") parameters.duckAmount = value;
+				else if (name == "duckAttackSpeed") parameters.duckAttackSpeed = value;
+				else if (name == "duckReleaseSpeed") parameters.duckReleaseSpeed = value;
+				else if (name == "filterMode") parameters.filterMode = (FilterModes)(int)value;
+				else if (name == "lowPassCutoff") parameters.lowPassCutoff = value;
+				else if (name == "highPassCutoff") parameters.highPassCutoff = value;
+				else if (name == "driveGain") parameters.driveGain = value;
+				else if (name == "driveMix") parameters.driveMix = value;
+				else if (name == "driveCutoff") parameters.driveCutoff = value;
+				else if (name == "driveIterations") parameters.driveIterations = (int)value;
+				else if (name == "dryVolume") parameters.dryVolume = value;
+				else if (name == "wetVolume") parameters.wetVolume = value;
+				else Check(false, "preset " + preset.name + " has unknown parameter " + name);
+			}
+			presets.push_back(preset);
+		}
+		Check(presets.size() > 1, "no presets found in Presets.cpp");
+		return presets;
+	}
+
+	// a burst of noise followed by silence, so the echoes and the feedback tail
+	// both get exercised. the same every time
+	inline std::vector<double> MakeInput(int length, uint64_t seed)
+	{
+		std::vector<double> input(length, 0.0);
+		Random random(seed);
+		for (int i = 0; i < length / 8; i++) input[i] = random.Bipolar() * .5;
+		return input;
+	}
+
+	// an engine that's been Reset with the given settings at 120 bpm, ready to render
+	inline CocoaDelayEngine MakeEngine(const EngineConfig &config, const EngineParameters &parameters, double sampleRate = 48000.0)
+	{
+		CocoaDelayEngine engine;
+		engine.SetConfig(config);
+		engine.SetTempo(120.0, false);
+		engine.SetParameters(parameters);
+		engine.Reset(sampleRate);
+		return engine;
+	}
+
+	// runs the engine over one input per channel in blocks of blockSize,
+	// and returns the outputs one after the other
+	inline std::vector<double> Render(CocoaDelayEngine &engine, const std::vector<std::vector<double>> &inputs, int blockSize = 512)
+	{
+		auto numChannels = (int)inputs.size();
+		auto length = (int)inputs[0].size();
+		std::vector<std::vector<double>> outputs(numChannels, std::vector<double>(length));
+		for (int offset = 0; offset < length; offset += blockSize)
+		{
+			auto n = length - offset < blockSize ? length - offset : blockSize;
+			const double* in[CocoaDelayEngine::maxChannels];
+			double* out[CocoaDelayEngine::maxChannels];
+			for (int c = 0; c < numChannels; c++)
+			{
+				in[c] = inputs[c].data() + offset;
+				out[c] = outputs[c].data() + offset;
+			}
+			engine.Process(in, out, n);
+		}
+		std::vector<double> result;
+		for (auto &output : outputs) result.insert(result.end(), output.begin(), output.end());
+		return result;
+	}
+
+	inline double PeakDifference(const std::vector<double> &a, const std::vector<double> &b)
+	{
+		auto peak = 0.0;
+		for (size_t i = 0; i < a.size() && i < b.size(); i++) peak = fmax(peak, fabs(a[i] - b[i]));
+		return peak;
+	}
+
+	inline double ToDecibels(double amplitude)
+	{
+		return amplitude > 0.0 ? 20.0 * log10(amplitude) : -INFINITY;
+	}
+}
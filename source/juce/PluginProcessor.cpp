@@ -36,12 +36,20 @@ CocoaDelayAudioProcessor::CocoaDelayAudioProcessor()
     driveMixParam = apvts.getRawParameterValue("driveMix");
     driveCutoffParam = apvts.getRawParameterValue("driveCutoff");
     driveIterationsParam = apvts.getRawParameterValue("driveIterations");
+    driveModeParam = apvts.getRawParameterValue("driveMode");
+    oversamplingParam = apvts.getRawParameterValue("oversampling");
     dryVolumeParam = apvts.getRawParameterValue("dryVolume");
     wetVolumeParam = apvts.getRawParameterValue("wetVolume");
+    reproducibleDriftParam = apvts.getRawParameterValue("reproducibleDrift");
+    driftSeedParam = apvts.getRawParameterValue("driftSeed");
+
+    // grows the engine's tape on the message thread if the host slows down
+    startTimerHz(10);
 }
 
 CocoaDelayAudioProcessor::~CocoaDelayAudioProcessor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -129,6 +137,11 @@ juce::AudioProcessorValueTreeState::ParameterLayout CocoaDelayAudioProcessor::cr
         [](const juce::String& text) { return text.getFloatValue() / 100.0f; }));
 
     params.push_back(std::make_unique<juce::AudioParameterInt>("driveIterations", "Drive Iterations", 1, 16, 1));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("driveMode", "Drive Mode",
+        juce::StringArray{ "Standard", "Antialiased" }, 0));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("oversampling", "Drive Oversampling",
+        juce::StringArray{ "1x", "2x", "4x", "8x" }, 0));
     
     // Dry/Wet Volume: 0% to 200%.
     auto volRange = juce::NormalisableRange<float>(0.0f, 2.0f, 0.01f);
@@ -139,6 +152,13 @@ juce::AudioProcessorValueTreeState::ParameterLayout CocoaDelayAudioProcessor::cr
          [](float value, int) { return juce::String(value * 100.0f, 0) + " %"; },
          [](const juce::String& text) { return text.getFloatValue() / 100.0f; }));
 
+    // with reproducible drift on, the drift noise restarts from the seed every time
+    // playback is prepared, so offline renders of the same project come out identical.
+    // each new instance starts from its own random seed, so instances only share their
+    // drift if the user sets them to the same seed. the seed is saved with the state
+    params.push_back(std::make_unique<juce::AudioParameterBool>("reproducibleDrift", "Reproducible Drift", false));
+    params.push_back(std::make_unique<juce::AudioParameterInt>("driftSeed", "Drift Seed", 0, 9999, (int)(Random::GetRandomSeed() % 10000)));
+
     return { params.begin(), params.end() };
 }
 
@@ -176,7 +196,7 @@ bool CocoaDelayAudioProcessor::isMidiEffect() const
 
 double CocoaDelayAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return CocoaDelayEngine::GetTailLength(GetEngineParameters(), hostTempo.load(std::memory_order_relaxed));
 }
 
 int CocoaDelayAudioProcessor::getNumPrograms()
@@ -206,12 +226,82 @@ void CocoaDelayAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void CocoaDelayAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    dt = 1.0 / sampleRate;
-    InitBuffer();
-    
-    // Reset filters/drive if needed
-    // lp.Reset(); 
-    // hp.Reset();
+    // the play head is only valid inside processBlock, so the tape is sized for the
+    // last tempo the host reported there, or for the longest it can be before the
+    // first block. the first block after this jumps straight to the host's tempo
+    // rather than ramping from the old one
+    transport = TransportSnapshot();
+    engine.SetParameters(GetEngineParameters());
+    auto config = engine.GetConfig();
+    config.reproducible = reproducibleDriftParam->load(std::memory_order_relaxed) >= .5f;
+    config.seed = (uint64_t)driftSeedParam->load(std::memory_order_relaxed);
+    // the layout only changes while playback is stopped, and always comes with another prepareToPlay
+    config.numChannels = juce::jlimit(1, CocoaDelayEngine::maxChannels, getTotalNumOutputChannels());
+    SetChannelGroups(getChannelLayoutOfBus(false, 0), config);
+    engine.SetConfig(config);
+    engine.Reset(sampleRate);
+}
+
+// pairs up the speakers that mirror each other, so the panning and stereo offset
+// only ever work between a left and its right. the centre, lfe and anything else
+// without a partner run on their own, and discrete channels are paired in order
+void CocoaDelayAudioProcessor::SetChannelGroups (const juce::AudioChannelSet& layout, EngineConfig& config)
+{
+    using Set = juce::AudioChannelSet;
+    static const Set::ChannelType speakerPairs[][2] =
+    {
+        { Set::left, Set::right },
+        { Set::leftCentre, Set::rightCentre },
+        { Set::leftSurround, Set::rightSurround },
+        { Set::leftSurroundSide, Set::rightSurroundSide },
+        { Set::leftSurroundRear, Set::rightSurroundRear },
+        { Set::wideLeft, Set::wideRight },
+        { Set::topFrontLeft, Set::topFrontRight },
+        { Set::topSideLeft, Set::topSideRight },
+        { Set::topRearLeft, Set::topRearRight },
+    };
+
+    // without a layout for every channel the engine falls back to pairing them in order
+    config.numChannelGroups = 0;
+    if (layout.size() != config.numChannels)
+        return;
+
+    bool grouped[EngineConfig::maxChannels] = {};
+    auto unpairedDiscrete = -1;
+    for (int c = 0; c < config.numChannels; ++c)
+    {
+        if (grouped[c])
+            continue;
+        grouped[c] = true;
+        auto type = layout.getTypeOfChannel (c);
+
+        if (type >= Set::discreteChannel0 && unpairedDiscrete != -1)
+        {
+            config.channelGroups[unpairedDiscrete].right = c;
+            unpairedDiscrete = -1;
+            continue;
+        }
+
+        auto& group = config.channelGroups[config.numChannelGroups];
+        group.left = c;
+        group.right = -1;
+        if (type >= Set::discreteChannel0)
+            unpairedDiscrete = config.numChannelGroups;
+        config.numChannelGroups++;
+
+        for (auto& speakerPair : speakerPairs)
+        {
+            if (type != speakerPair[0] && type != speakerPair[1])
+                continue;
+            auto partner = layout.getChannelIndexForType (type == speakerPair[0] ? speakerPair[1] : speakerPair[0]);
+            if (partner < 0 || grouped[partner])
+                break;
+            grouped[partner] = true;
+            group.left = type == speakerPair[0] ? c : partner;
+            group.right = type == speakerPair[0] ? partner : c;
+            break;
+        }
+    }
 }
 
 void CocoaDelayAudioProcessor::releaseResources()
@@ -227,12 +317,10 @@ bool CocoaDelayAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // anything from mono up to 7.1.4. prepareToPlay pairs each left speaker with
+    // its right, and the centre and lfe are delayed on their own
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels < 1 || numChannels > CocoaDelayEngine::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -246,7 +334,25 @@ bool CocoaDelayAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 }
 #endif
 
-void CocoaDelayAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void CocoaDelayAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    ProcessBuffer(buffer);
+}
+
+// hosts with a 64-bit mix engine can hand over their buffers as they are,
+// so nothing gets rounded to single precision on the way in or out
+void CocoaDelayAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    ProcessBuffer(buffer);
+}
+
+bool CocoaDelayAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template<class T>
+void CocoaDelayAudioProcessor::ProcessBuffer (juce::AudioBuffer<T>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -255,72 +361,20 @@ void CocoaDelayAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // Pointers to channel data
-    float* channelL = buffer.getWritePointer(0);
-    float* channelR = totalNumOutputChannels > 1 ? buffer.getWritePointer(1) : channelL;
-    
-    float* inputs[2] = { channelL, channelR };
-
-    int nFrames = buffer.getNumSamples();
+    UpdateTempo();
+    engine.SetParameters(GetEngineParameters());
 
-    for (int s = 0; s < nFrames; s++)
+    // the channel count was fixed in prepareToPlay, so there's a pointer for every
+    // channel the engine could ask for. any past the end of the buffer repeat the first
+    const T* inputs[CocoaDelayEngine::maxChannels];
+    T* outputs[CocoaDelayEngine::maxChannels];
+    for (int c = 0; c < CocoaDelayEngine::maxChannels; ++c)
     {
-        if (!warmedUp)
-        {
-            GetReadPositions(readPositionL, readPositionR);
-            warmedUp = true;
-        }
-
-        UpdateParameters();
-        UpdateReadPositions();
-        
-        double inputSum = inputs[0][s];
-        if (totalNumOutputChannels > 1) inputSum += inputs[1][s];
-        UpdateDucking(inputSum);
-        
-        UpdateLfo();
-        UpdateDrift();
-
-        // read from buffer
-        auto outL = GetSample(bufferL, writePosition - readPositionL);
-        auto outR = GetSample(bufferR, writePosition - readPositionR);
-
-        // circular panning
-        Util::adjustPanning(outL, outR, circularPanAmount, outL, outR);
-
-        // filters
-        lp.Process(dt, outL, outR, (double)*lowPassCutoffParam);
-        hp.Process(dt, outL, outR, (double)*highPassCutoffParam, true);
-
-        // drive
-        auto driveAmount = (double)*driveGainParam;
-        auto driveMix = (double)*driveMixParam;
-        if (driveAmount > 0)
-        {
-            auto iterations = (int)*driveIterationsParam;
-            for (int i = 0; i < iterations; i++)
-            {
-                outL = statefulDrive.Process(outL * driveAmount, driveMix) / driveAmount;
-                outR = statefulDrive.Process(outR * driveAmount, driveMix) / driveAmount;
-                driveFilter.Process(dt, outL, outR, (double)*driveCutoffParam, outL, outR);
-            }
-        }
-
-        // write to buffer
-        WriteToBuffer(inputs, s, outL, outR);
-        UpdateWritePosition();
-
-        // output
-        auto dry = (double)*dryVolumeParam;
-        auto wet = (double)*wetVolumeParam;
-        auto duckValue = (double)*duckAmountParam * duckFollower;
-        duckValue = duckValue > 1.0 ? 1.0 : duckValue;
-        wet *= 1.0 - duckValue;
-        
-        inputs[0][s] = inputs[0][s] * dry + outL * wet;
-        if (totalNumOutputChannels > 1)
-            inputs[1][s] = inputs[1][s] * dry + outR * wet;
+        outputs[c] = buffer.getWritePointer(c < buffer.getNumChannels() ? c : 0);
+        inputs[c] = outputs[c];
     }
+
+    engine.Process(inputs, outputs, buffer.getNumSamples());
 }
 
 //==============================================================================
@@ -359,202 +413,72 @@ void CocoaDelayAudioProcessor::setStateInformation (const void* data, int sizeIn
 
 //==============================================================================
 
-void CocoaDelayAudioProcessor::InitBuffer()
-{
-    bufferL.clear();
-    bufferR.clear();
-    int size = (int)(getSampleRate() * tapeLength);
-    if (size <= 0) size = 44100 * tapeLength; // Fallback
-    
-    bufferL.resize(size, 0.0);
-    bufferR.resize(size, 0.0);
-
-    writePosition = 0;
-    GetReadPositions(readPositionL, readPositionR);
-}
-
-double CocoaDelayAudioProcessor::GetDelayTime()
-{
-    double delayTime = 0.0;
-    
-    // Helper for BPM
-    double bpm = 120.0;
+EngineParameters CocoaDelayAudioProcessor::GetEngineParameters() const
+{
+    // called once per block. the values are independent of each other, so relaxed loads are enough
+    EngineParameters p;
+    p.delayTime = delayTimeParam->load(std::memory_order_relaxed);
+    p.lfoAmount = lfoAmountParam->load(std::memory_order_relaxed);
+    p.lfoFrequency = lfoFrequencyParam->load(std::memory_order_relaxed);
+    p.driftAmount = driftAmountParam->load(std::memory_order_relaxed);
+    p.driftSpeed = driftSpeedParam->load(std::memory_order_relaxed);
+    p.tempoSyncTime = (TempoSyncTimes)(int)tempoSyncTimeParam->load(std::memory_order_relaxed);
+    p.feedback = feedbackParam->load(std::memory_order_relaxed);
+    p.stereoOffset = stereoOffsetParam->load(std::memory_order_relaxed);
+    p.panMode = (PanModes)(int)panModeParam->load(std::memory_order_relaxed);
+    // Convert -50..50 range to radians (-pi/2 .. pi/2)
+    p.pan = (panParam->load(std::memory_order_relaxed) / 50.0) * (Util::pi * 0.5);
+    p.duckAmount = duckAmountParam->load(std::memory_order_relaxed);
+    p.duckAttackSpeed = duckAttackSpeedParam->load(std::memory_order_relaxed);
+    p.duckReleaseSpeed = duckReleaseSpeedParam->load(std::memory_order_relaxed);
+    p.filterMode = (FilterModes)(int)filterModeParam->load(std::memory_order_relaxed);
+    p.lowPassCutoff = lowPassCutoffParam->load(std::memory_order_relaxed);
+    p.highPassCutoff = highPassCutoffParam->load(std::memory_order_relaxed);
+    p.driveGain = driveGainParam->load(std::memory_order_relaxed);
+    p.driveMix = driveMixParam->load(std::memory_order_relaxed);
+    p.driveCutoff = driveCutoffParam->load(std::memory_order_relaxed);
+    p.driveIterations = (int)driveIterationsParam->load(std::memory_order_relaxed);
+    p.driveMode = (DriveModes)(int)driveModeParam->load(std::memory_order_relaxed);
+    p.oversampling = 1 << (int)oversamplingParam->load(std::memory_order_relaxed);
+    p.dryVolume = dryVolumeParam->load(std::memory_order_relaxed);
+    p.wetVolume = wetVolumeParam->load(std::memory_order_relaxed);
+    return p;
+}
+
+CocoaDelayAudioProcessor::TransportSnapshot CocoaDelayAudioProcessor::GetTransport()
+{
+    TransportSnapshot snapshot;
     if (auto* ph = getPlayHead())
     {
         if (auto pos = ph->getPosition())
-            if (pos->getBpm().hasValue())
-                bpm = *pos->getBpm();
-    }
-    
-    auto beatLength = 60.0 / bpm;
-    
-    int modeIndex = (int)*tempoSyncTimeParam;
-    
-    // Re-map to Params::TempoSyncTimes or use switch case if order is same
-    Params::TempoSyncTimes mode = (Params::TempoSyncTimes)modeIndex;
-
-    switch (mode)
-    {
-    case Params::TempoSyncTimes::tempoSyncOff:
-        delayTime = (double)*delayTimeParam;
-        break;
-    case Params::TempoSyncTimes::whole:               delayTime = beatLength * 4;    break;
-    case Params::TempoSyncTimes::dottedHalf:          delayTime = beatLength * 3;    break;
-    case Params::TempoSyncTimes::half:                delayTime = beatLength * 2;    break;
-    case Params::TempoSyncTimes::tripletHalf:         delayTime = beatLength * 4.0/3.0;  break;
-    case Params::TempoSyncTimes::dottedQuarter:       delayTime = beatLength * 3.0/2.0;  break;
-    case Params::TempoSyncTimes::quarter:             delayTime = beatLength * 1;    break;
-    case Params::TempoSyncTimes::tripletQuarter:      delayTime = beatLength * 2.0/3.0;  break;
-    case Params::TempoSyncTimes::dottedEighth:        delayTime = beatLength * 3.0/4.0;  break;
-    case Params::TempoSyncTimes::eighth:              delayTime = beatLength * 1.0/2.0;  break;
-    case Params::TempoSyncTimes::tripletEighth:       delayTime = beatLength * 1.0/3.0;  break;
-    case Params::TempoSyncTimes::dottedSixteenth:     delayTime = beatLength * 3.0/8.0;  break;
-    case Params::TempoSyncTimes::sixteenth:           delayTime = beatLength * 1.0/4.0;  break;
-    case Params::TempoSyncTimes::tripletSixteenth:    delayTime = beatLength * 1.0/6.0;  break;
-    case Params::TempoSyncTimes::dottedThirtysecond:  delayTime = beatLength * 3.0/16.0; break;
-    case Params::TempoSyncTimes::thirtysecond:        delayTime = beatLength * 1.0/8.0;  break;
-    case Params::TempoSyncTimes::tripletThirtysecond: delayTime = beatLength * 1.0/12.0; break;
-    case Params::TempoSyncTimes::dottedSixtyforth:    delayTime = beatLength * 3.0/32.0; break;
-    case Params::TempoSyncTimes::sixtyforth:          delayTime = beatLength * 1.0/16.0; break;
-    case Params::TempoSyncTimes::tripletSixtyforth:   delayTime = beatLength * 1.0/24.0; break;
-    default: delayTime = (double)*delayTimeParam; break;
-    }
-
-    // modulation
-    auto lfoAmount = (double)*lfoAmountParam;
-    if (lfoAmount != 0.0) delayTime = pow(delayTime, 1.0 + lfoAmount * sin(lfoPhase * 2 * Util::pi));
-    auto driftAmount = (double)*driftAmountParam;
-    if (driftAmount != 0.0) delayTime = pow(delayTime, 1.0 + driftAmount * sin(driftPhase));
-
-    return delayTime;
-}
-
-void CocoaDelayAudioProcessor::GetReadPositions(double &l, double &r)
-{
-    auto offset = (double)*stereoOffsetParam * .5;
-    auto baseTime = GetDelayTime();
-    auto timeL = pow(baseTime, 1.0 + offset);
-    auto timeR = pow(baseTime, 1.0 - offset);
-    l = timeL * getSampleRate();
-    r = timeR * getSampleRate();
-}
-
-void CocoaDelayAudioProcessor::UpdateReadPositions()
-{
-    double targetReadPositionL, targetReadPositionR;
-    GetReadPositions(targetReadPositionL, targetReadPositionR);
-    readPositionL += (targetReadPositionL - readPositionL) * 10.0 * dt;
-    readPositionR += (targetReadPositionR - readPositionR) * 10.0 * dt;
-}
-
-void CocoaDelayAudioProcessor::UpdateWritePosition()
-{
-    writePosition += 1;
-    if (bufferL.size() > 0)
-        writePosition %= bufferL.size();
-}
-
-void CocoaDelayAudioProcessor::UpdateParameters()
-{
-    // pan mode fadeout
-    auto targetMode = (Params::PanModes)(int)*panModeParam;
-    
-    if (currentPanMode != targetMode)
-    {
-        parameterChangeVolume -= 100.0 * dt;
-        if (parameterChangeVolume <= 0.0)
         {
-            parameterChangeVolume = 0.0;
-            currentPanMode = targetMode;
+            if (auto bpm = pos->getBpm())
+                snapshot.bpm = *bpm;
+            if (auto ppq = pos->getPpqPosition())
+                snapshot.ppqPosition = *ppq;
+            snapshot.isPlaying = pos->getIsPlaying();
         }
     }
-    else if (parameterChangeVolume < 1.0)
-    {
-        parameterChangeVolume += 100.0 * dt;
-        if (parameterChangeVolume > 1.0) parameterChangeVolume = 1.0;
-    }
-
-    // pan amount smoothing
-    // Convert -50..50 range to radians (-pi/2 .. pi/2)
-    auto panValue = (double)*panParam;
-    auto panAmount = (panValue / 50.0) * (Util::pi * 0.5);
-    
-    auto stationaryPanAmountTarget = (currentPanMode == Params::PanModes::stationary || currentPanMode == Params::PanModes::pingPong) ? panAmount : 0.0;
-    stationaryPanAmount += (stationaryPanAmountTarget - stationaryPanAmount) * 100.0 * dt;
-    auto circularPanAmountTarget = (currentPanMode == Params::PanModes::circular ? panAmount : 0.0);
-    circularPanAmount += (circularPanAmountTarget - circularPanAmount) * 100.0 * dt;
-    
-    // Update filter mode
-    auto fMode = (FilterModes)(int)*filterModeParam;
-    lp.SetMode(fMode);
-    hp.SetMode(fMode);
+    return snapshot;
 }
 
-void CocoaDelayAudioProcessor::UpdateDucking(double input)
+void CocoaDelayAudioProcessor::timerCallback()
 {
-    auto attackSpeed = (double)*duckAttackSpeedParam;
-    auto releaseSpeed = (double)*duckReleaseSpeedParam;
-    auto speed = duckFollower < std::abs(input) ? attackSpeed : releaseSpeed;
-    duckFollower += (std::abs(input) - duckFollower) * speed * dt;
+    engine.UpdateTape();
 }
 
-void CocoaDelayAudioProcessor::UpdateLfo()
+void CocoaDelayAudioProcessor::UpdateTempo()
 {
-    lfoPhase += (double)*lfoFrequencyParam * dt;
-    while (lfoPhase > 1.0) lfoPhase -= 1.0;
-}
+    auto previous = transport;
+    transport = GetTransport();
 
-void CocoaDelayAudioProcessor::UpdateDrift()
-{
-    auto driftSpeed = (double)*driftSpeedParam;
-    driftVelocity += Util::random() * 10000.0 * driftSpeed * dt;
-    driftVelocity -= driftVelocity * 2.0 * sqrt(driftSpeed) * dt;
-    driftPhase += driftVelocity * dt;
-}
-
-double CocoaDelayAudioProcessor::GetSample(std::vector<double> &buffer, double position)
-{
-    if (buffer.empty()) return 0.0;
-    
-    int sz = (int)buffer.size();
-    int p0 = Util::wrap(floor(position) - 1, 0, sz - 1);
-    int p1 = Util::wrap(floor(position), 0, sz - 1);
-    int p2 = Util::wrap(ceil(position), 0, sz - 1);
-    int p3 = Util::wrap(ceil(position) + 1, 0, sz - 1);
-
-    auto x = position - floor(position);
-    auto y0 = buffer[p0];
-    auto y1 = buffer[p1];
-    auto y2 = buffer[p2];
-    auto y3 = buffer[p3];
-
-    return Util::interpolate(x, y0, y1, y2, y3);
-}
-
-void CocoaDelayAudioProcessor::WriteToBuffer(float** inputs, int s, double outL, double outR)
-{
-    auto writeL = 0.0, writeR = 0.0;
-    writeL += inputs[0][s];
-    // Handle mono input/output cases slightly gracefully, though this assumes stereo usually
-    writeR += (getTotalNumOutputChannels() > 1) ? inputs[1][s] : inputs[0][s]; 
-    
-    Util::adjustPanning(writeL, writeR, stationaryPanAmount * .5, writeL, writeR);
-    writeL += outL * (double)*feedbackParam;
-    writeR += outR * (double)*feedbackParam;
-    
-    if (bufferL.empty() || bufferR.empty()) return;
-
-    switch (currentPanMode)
-    {
-    case Params::PanModes::pingPong:
-        bufferL[writePosition] = writeR * parameterChangeVolume;
-        bufferR[writePosition] = writeL * parameterChangeVolume;
-        break;
-    default:
-        bufferL[writePosition] = writeL * parameterChangeVolume;
-        bufferR[writePosition] = writeR * parameterChangeVolume;
-        break;
-    }
+    // while the transport keeps playing forward, tempo changes are treated as a ramp
+    // and the engine interpolates the beat length across the block. after a stop,
+    // a loop or a jump, the new tempo applies straight away.
+    auto continuous = transport.isPlaying && previous.isPlaying
+        && transport.ppqPosition >= previous.ppqPosition;
+    engine.SetTempo(transport.bpm, continuous);
+    hostTempo.store(transport.bpm, std::memory_order_relaxed);
 }
 
 //==============================================================================
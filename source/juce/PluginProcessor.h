@@ -1,12 +1,10 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "Filter.h"
-#include "StatefulDrive.h"
-#include "Parameters.h"
-#include <vector>
+#include "CocoaDelayEngine.h"
 
-class CocoaDelayAudioProcessor  : public juce::AudioProcessor
+class CocoaDelayAudioProcessor  : public juce::AudioProcessor,
+                                  private juce::Timer
 {
 public:
     //==============================================================================
@@ -22,6 +20,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -52,48 +52,27 @@ private:
     //==============================================================================
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
-    void InitBuffer();
-    void UpdateReadPositions();
-    void UpdateWritePosition();
-    void UpdateParameters();
-    void UpdateDucking(double input);
-    void UpdateLfo();
-    void UpdateDrift();
-    double GetDelayTime();
-    void GetReadPositions(double & l, double & r);
-    double GetSample(std::vector<double> &buffer, double position);
-    void WriteToBuffer(float** inputs, int s, double outL, double outR);
-
-    static const int tapeLength = 10;
-
-    // delay
-    std::vector<double> bufferL;
-    std::vector<double> bufferR;
-    int writePosition;
-    double readPositionL;
-    double readPositionR;
-    bool warmedUp = false;
-    double dt = 0.0;
-
-    // fading parameters
-    Params::PanModes currentPanMode = Params::PanModes::stationary;
-    double parameterChangeVolume = 1.0;
-    double stationaryPanAmount = 0.0;
-    double circularPanAmount = 0.0;
-
-    // filters
-    MultiFilter lp;
-    MultiFilter hp;
-
-    // drive
-    StatefulDrive statefulDrive;
-    DualFilter<TwoPoleFilter> driveFilter;
-
-    // modulation
-    double duckFollower = 0.0;
-    double lfoPhase = 0.0;
-    double driftVelocity = 0.0;
-    double driftPhase = 0.0;
+    // host transport state, read from the play head once per block
+    struct TransportSnapshot
+    {
+        double bpm = 120.0;
+        double ppqPosition = 0.0;
+        bool isPlaying = false;
+    };
+
+    template<class T> void ProcessBuffer (juce::AudioBuffer<T>& buffer);
+    EngineParameters GetEngineParameters() const;
+    TransportSnapshot GetTransport();
+    void timerCallback() override;
+    static void SetChannelGroups (const juce::AudioChannelSet& layout, EngineConfig& config);
+    void UpdateTempo();
+
+    CocoaDelayEngine engine;
+    TransportSnapshot transport;
+
+    // the tail length depends on the tempo when the delay is synced, and
+    // the host can ask for it from any thread
+    std::atomic<double> hostTempo { 120.0 };
 
     // Parameter pointers
     std::atomic<float>* delayTimeParam = nullptr;
@@ -116,8 +95,12 @@ private:
     std::atomic<float>* driveMixParam = nullptr;
     std::atomic<float>* driveCutoffParam = nullptr;
     std::atomic<float>* driveIterationsParam = nullptr;
+    std::atomic<float>* driveModeParam = nullptr;
+    std::atomic<float>* oversamplingParam = nullptr;
     std::atomic<float>* dryVolumeParam = nullptr;
     std::atomic<float>* wetVolumeParam = nullptr;
+    std::atomic<float>* reproducibleDriftParam = nullptr;
+    std::atomic<float>* driftSeedParam = nullptr;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CocoaDelayAudioProcessor)
 };